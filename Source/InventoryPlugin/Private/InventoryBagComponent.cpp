@@ -0,0 +1,76 @@
+/**
+ * Copyright 2019-2020 - Russ 'trdwll' Treadwell https://trdwll.com
+ */
+
+
+#include "InventoryBagComponent.h"
+
+#include "Net/UnrealNetwork.h"
+
+UInventoryBagComponent::UInventoryBagComponent()
+{
+	m_ParentInventory = nullptr;
+	m_BagInstanceID = 0;
+	m_ContentWeight = 0.0f;
+}
+
+void UInventoryBagComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(UInventoryBagComponent, m_ParentInventory);
+	DOREPLIFETIME(UInventoryBagComponent, m_BagInstanceID);
+}
+
+void UInventoryBagComponent::InitializeBag(UInventoryComponent* Parent, int32 InstanceID, int32 Slots)
+{
+	m_ParentInventory = Parent;
+	m_BagInstanceID = InstanceID;
+
+	m_InventoryRowsNum = 1;
+	m_InventoryColumnsNum = (uint8)FMath::Clamp(Slots, 1, 255);
+	m_ActionBarSlotsNum = 0;
+	m_bUseFootprints = false;
+}
+
+void UInventoryBagComponent::AdoptContents(const TArray<FInventoryItemMeta>& Contents)
+{
+	EnsureMaterialized();
+	AddItems(Contents);
+}
+
+void UInventoryBagComponent::OnItemTotalChanged(FName Key, int32 Delta, float WeightDelta)
+{
+	// Restored contents were counted when they were first put in
+	if (IsRestoring() || GetOwnerRole() != ROLE_Authority)
+	{
+		return;
+	}
+
+	int32& Total = m_ContentTotals.FindOrAdd(Key);
+	Total += Delta;
+
+	if (Total <= 0)
+	{
+		m_ContentTotals.Remove(Key);
+	}
+
+	m_ContentWeight += WeightDelta;
+
+	if (m_ParentInventory)
+	{
+		m_ParentInventory->AddBagContents(Key, Delta, WeightDelta);
+	}
+}
+
+float UInventoryBagComponent::GetWeightLeft() const
+{
+	// Restored contents are already part of the parent's weight
+	if (IsRestoring())
+	{
+		return MAX_flt;
+	}
+
+	const float WeightLeft = Super::GetWeightLeft();
+	return m_ParentInventory ? FMath::Min(WeightLeft, m_ParentInventory->GetWeightLeft()) : WeightLeft;
+}
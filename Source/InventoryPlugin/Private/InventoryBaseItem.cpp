@@ -10,7 +10,7 @@
 
 AInventoryBaseItem::AInventoryBaseItem()
 {
-	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bCanEverTick = false;
 
 	bReplicates = true;
 	bAlwaysRelevant = true;
@@ -21,11 +21,6 @@ void AInventoryBaseItem::BeginPlay()
 	Super::BeginPlay();
 }
 
-void AInventoryBaseItem::Tick(float DeltaTime)
-{
-	Super::Tick(DeltaTime);
-}
-
 void AInventoryBaseItem::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
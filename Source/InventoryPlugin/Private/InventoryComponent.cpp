@@ -4,19 +4,39 @@
 
 
 #include "InventoryComponent.h"
+#include "InventoryBagComponent.h"
 #include "InventoryBaseItem.h"
+#include "InventoryStashComponent.h"
+#include "InventorySubsystem.h"
+#include "InventoryCraftingSubsystem.h"
+#include "InventoryItemSubsystem.h"
+#include "InventoryRecipe.h"
 
 #include "Engine.h"
 #include "Net/UnrealNetwork.h"
 #include "Async/ParallelFor.h"
+#include "Engine/AssetManager.h"
 
 #include "GameFramework/Actor.h"
 #include "GameFramework/Character.h"
 #include "GameFramework/Controller.h"
+#include "GameFramework/GameStateBase.h"
 
 #include "Kismet/KismetMathLibrary.h"
 #include "Kismet/KismetStringLibrary.h"
 
+/** How long an acknowledged prediction is shown before it's dropped if the replicated slot never catches up. */
+static const float PredictionTimeout = 1.0f;
+
+/** How long the client waits for an operation to be acknowledged before sending it again. */
+static const float OperationResendInterval = 0.25f;
+
+/** The most times a recipe can be crafted in one go, keeps the input and output quantities well within range. */
+static const int32 MaxCraftCount = 1000;
+
+/** How many of the most recent rejected operations are sent with every ack. */
+static const int32 MaxAckedRejections = 16;
+
 
 UInventoryComponent::UInventoryComponent()
 {
@@ -27,6 +47,31 @@ UInventoryComponent::UInventoryComponent()
 	m_InventoryRowsNum = 5;
 	m_InventoryColumnsNum = 6;
 	m_ActionBarSlotsNum = 5;
+	m_bUseFootprints = false;
+	m_bReplicateSlots = true;
+	m_MaxWeight = 0.0f;
+
+	m_bPickupTracePending = false;
+
+	m_LastSentSequence = 0;
+	m_LastAppliedSequence = 0;
+	m_LastReceivedSequence = 0;
+	m_SlotVersionBase = 0;
+
+	m_InstanceData.Owner = this;
+	m_bPruneInstancesPending = false;
+	m_LastCastSerial = 0;
+	m_CraftingSubsystem = nullptr;
+	m_ItemSubsystem = nullptr;
+
+	m_EmptySlotCount = 0;
+	m_TotalWeight = 0.0f;
+	m_BagWeight = 0.0f;
+	m_EncumbranceLevel = 0;
+	m_ChangeBatchDepth = 0;
+	m_bChangedInBatch = false;
+	m_bSnapshotDirty = false;
+	m_bSnapshotAllDirty = true;
 }
 
 void UInventoryComponent::BeginPlay()
@@ -41,353 +86,3264 @@ void UInventoryComponent::BeginPlay()
 		return;
 	}
 
-	m_InventoryItems.SetNum(m_InventoryRowsNum * m_InventoryColumnsNum + m_ActionBarSlotsNum);
+	m_CraftingSubsystem = GetWorld()->GetGameInstance() ? GetWorld()->GetGameInstance()->GetSubsystem<UInventoryCraftingSubsystem>() : nullptr;
+	m_ItemSubsystem = GetWorld()->GetGameInstance() ? GetWorld()->GetGameInstance()->GetSubsystem<UInventoryItemSubsystem>() : nullptr;
+
+	InitializeSlots();
+
+	if (GetOwnerRole() == ROLE_Authority)
+	{
+		if (UInventorySubsystem* const Subsystem = GetWorld()->GetSubsystem<UInventorySubsystem>())
+		{
+			Subsystem->RegisterInventory(this);
+		}
+	}
+
+	if (m_ItemSubsystem)
+	{
+		m_ItemDefinitionsHandle = m_ItemSubsystem->OnItemDefinitionsChanged.AddUObject(this, &UInventoryComponent::OnItemDefinitionsChanged);
+
+		// Items may have been reloaded on the server before joining, one inventory asks for them
+		if (GetOwnerRole() == ROLE_AutonomousProxy && m_ItemSubsystem->ShouldRequestDefinitions())
+		{
+			Server_RequestItemDefinitions(m_ItemSubsystem->GetRegistryVersion());
+		}
+	}
 }
 
-void UInventoryComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+void UInventoryComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+	m_bPickupTracePending = false;
+	m_PickupTrace = FTraceHandle();
 
-	DOREPLIFETIME(UInventoryComponent, m_InventoryItems); // TODO: Possibly owner only?
+	if (UInventorySubsystem* const Subsystem = GetWorld() ? GetWorld()->GetSubsystem<UInventorySubsystem>() : nullptr)
+	{
+		Subsystem->UnregisterInventory(this);
+	}
+
+	if (m_ItemSubsystem)
+	{
+		m_ItemSubsystem->OnItemDefinitionsChanged.Remove(m_ItemDefinitionsHandle);
+		m_ItemDefinitionsHandle.Reset();
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
-class AInventoryBaseItem* UInventoryComponent::GetActorInView()
+void UInventoryComponent::InitializeSlots()
 {
-	ACharacter* const Character = Cast<ACharacter>(GetOwner());
+	AllocateSlots();
+}
 
-	if (Character == nullptr || Character->GetController() == nullptr)
+void UInventoryComponent::AllocateSlots()
+{
+	if (m_bUseFootprints && m_InventoryColumnsNum > FInventoryGrid::MaxColumns)
 	{
-		PRINT("Character or Controller are nullptr");
-		return nullptr;
+		LOG("Footprints need the inventory to be at most %d columns wide, using 1 item per slot", FInventoryGrid::MaxColumns);
+		m_bUseFootprints = false;
 	}
 
-	FVector CameraLocation;
-	FRotator CameraRotation;
-	Character->GetController()->GetPlayerViewPoint(CameraLocation, CameraRotation);
+	m_InventoryItems.SetNum(m_InventoryRowsNum * m_InventoryColumnsNum + m_ActionBarSlotsNum);
 
-	FVector EndLocation = CameraLocation + (CameraRotation.Vector() * m_MaxUseDistance);
+	// Anything still holding a version from before the slots were freed sees a change
+	for (FInventoryItemStack& Stack : m_InventoryItems)
+	{
+		Stack.Version = m_SlotVersionBase + 1;
+	}
 
-	FCollisionQueryParams TraceParams(FName(TEXT("")), true, GetOwner());
-	TraceParams.bTraceComplex = true;
+	RebuildSlotIndex();
+}
 
-	FHitResult HitRes;
-	GetWorld()->LineTraceSingleByChannel(HitRes, CameraLocation, EndLocation, ECC_GameTraceChannel18, TraceParams);
+void UInventoryComponent::ReleaseSlots()
+{
+	if (GetOwnerRole() == ROLE_Authority)
+	{
+		for (const FInventoryItemStack& Stack : m_InventoryItems)
+		{
+			UpdateHeldClass(Stack, -1);
+		}
+	}
 
-#ifdef _DEBUG
-	DrawDebugLine(GetWorld(), CameraLocation, EndLocation, FColor::Yellow, false, 10.0f, 0, 1.0f);
-	DrawDebugSphere(GetWorld(), HitRes.Location, 3.0f, 5, FColor::Orange);
-#endif
+	for (const FInventoryItemStack& Stack : m_InventoryItems)
+	{
+		m_SlotVersionBase = FMath::Max(m_SlotVersionBase, Stack.Version);
+	}
 
-	return Cast<AInventoryBaseItem>(HitRes.Actor);
+	m_InventoryItems.Empty();
+	RebuildSlotIndex();
 }
 
-void UInventoryComponent::PickupItem()
+const FInventoryItem* UInventoryComponent::FindItemData(const FName& Name)
 {
-	Server_PickupItem();
+	// Looked up before BeginPlay
+	if (m_ItemSubsystem == nullptr && GetWorld() && GetWorld()->GetGameInstance())
+	{
+		m_ItemSubsystem = GetWorld()->GetGameInstance()->GetSubsystem<UInventoryItemSubsystem>();
+	}
+
+	if (m_ItemSubsystem)
+	{
+		return m_ItemSubsystem->FindItem(Name);
+	}
+
+	// No game instance (editor tools etc), the row is shared so its ID is left as it is
+	UDataTable* const DataTable = GetItemDataTable();
+	return DataTable ? DataTable->FindRow<FInventoryItem>(Name, TEXT(""), false) : nullptr;
 }
 
-bool UInventoryComponent::Server_PickupItem_Validate() { return true; }
-void UInventoryComponent::Server_PickupItem_Implementation()
+void UInventoryComponent::ResolveItem(FInventoryItemStack& Stack)
 {
-	if (IsInventoryFull())
+	if (Stack.IsEmptySlot() || Stack.InventoryItem.ID.IsNone())
 	{
-		PRINT("Your inventory is full!");
 		return;
 	}
 
-	AInventoryBaseItem* const LookatActor = GetActorInView();
+	if (const FInventoryItem* const Item = FindItemData(Stack.InventoryItem.ID))
+	{
+		Stack.InventoryItem = *Item;
+	}
+}
+
+void UInventoryComponent::OnItemDefinitionsChanged(const TSet<FName>& ItemIDs)
+{
+	bool bChanged = false;
+
+	// Stacks whose footprint changed, the server moves them if they now overlap something
+	TArray<TPair<int32, FInventoryItemStack>, TInlineAllocator<8>> Resized;
 
-	if (LookatActor)
+	// Not a slot change, the copies are refreshed on every machine so the version stays the same and nothing replicates
+	for (int32 i = 0; i < m_InventoryItems.Num(); i++)
 	{
-		FName RowName = LookatActor->GetInventoryItemMeta().ItemRowName;
-		int32 Quantity = LookatActor->GetInventoryItemMeta().Quantity;
+		FInventoryItemStack& Stack = m_InventoryItems[i];
 
-		FInventoryItemStack ItemStack(GetItemData(RowName), Quantity);
+		if (Stack.IsEmptySlot() || !ItemIDs.Contains(Stack.InventoryItem.ID))
+		{
+			continue;
+		}
 
-		OnItemPickedUp.Broadcast(GetOwner(), ItemStack);
-		AddItem(ItemStack);
+		FInventoryItemStack Refreshed = Stack;
+		ResolveItem(Refreshed);
+
+		if (GetOwnerRole() == ROLE_Authority && IsGridSlot(i) && Refreshed.GetFootprint() != Stack.GetFootprint())
+		{
+			Resized.Emplace(i, MoveTemp(Refreshed));
+			continue;
+		}
+
+		Stack = MoveTemp(Refreshed);
+		OnSlotChanged.Broadcast(i);
+		bChanged = true;
+	}
+
+	for (TPair<int32, FPredictedSlot>& Predicted : m_PredictedSlots)
+	{
+		if (!Predicted.Value.Stack.IsEmptySlot() && ItemIDs.Contains(Predicted.Value.Stack.InventoryItem.ID))
+		{
+			ResolveItem(Predicted.Value.Stack);
+		}
+	}
+
+	if (bChanged)
+	{
+		// Weights, stack sizes and footprints may have changed
+		RebuildSlotIndex();
+		OnInventoryChanged.Broadcast();
+	}
+
+	if (Resized.Num() > 0)
+	{
+		FInventoryChangeBatch Batch(this);
 
-		LookatActor->Destroy();
+		for (const TPair<int32, FInventoryItemStack>& Slot : Resized)
+		{
+			ReplaceSlot(Slot.Key, Slot.Value);
+		}
 	}
 }
 
-void UInventoryComponent::DropItem(int32 ItemIndex, int32 Quantity)
+void UInventoryComponent::SendItemDefinitions(int32 Version, const TArray<FInventoryItem>& Items, const TArray<FName>& RemovedItems)
+{
+	// Keep each RPC well under the bunch size limit, a removed item is only its name
+	static const int32 MaxItemsPerRPC = 256;
+	static const int32 MaxRemovedPerRPC = 1024;
+
+	for (int32 Part = 0; Part * MaxItemsPerRPC < Items.Num() || Part * MaxRemovedPerRPC < RemovedItems.Num(); Part++)
+	{
+		const int32 FirstItem = FMath::Min(Part * MaxItemsPerRPC, Items.Num());
+		const int32 FirstRemoved = FMath::Min(Part * MaxRemovedPerRPC, RemovedItems.Num());
+
+		Client_ReceiveItemDefinitions(Version,
+			TArray<FInventoryItem>(Items.GetData() + FirstItem, FMath::Min(MaxItemsPerRPC, Items.Num() - FirstItem)),
+			TArray<FName>(RemovedItems.GetData() + FirstRemoved, FMath::Min(MaxRemovedPerRPC, RemovedItems.Num() - FirstRemoved)));
+	}
+}
+
+void UInventoryComponent::Client_ReceiveItemDefinitions_Implementation(int32 Version, const TArray<FInventoryItem>& Items, const TArray<FName>& RemovedItems)
 {
-	Server_DropItem(ItemIndex, Quantity);
+	if (m_ItemSubsystem)
+	{
+		m_ItemSubsystem->ApplyDefinitions(Version, Items, RemovedItems);
+	}
 }
 
-bool UInventoryComponent::Server_DropItem_Validate(int32 ItemIndex, int32 Quantity) { return true; }
-void UInventoryComponent::Server_DropItem_Implementation(int32 ItemIndex, int32 Quantity)
+bool UInventoryComponent::Server_RequestItemDefinitions_Validate(int32 KnownVersion) { return KnownVersion >= 0; }
+void UInventoryComponent::Server_RequestItemDefinitions_Implementation(int32 KnownVersion)
 {
-	if (!m_InventoryItems.IsValidIndex(ItemIndex) && !m_InventoryItems[ItemIndex].IsEmptySlot())
+	UInventorySubsystem* const Subsystem = GetWorld()->GetSubsystem<UInventorySubsystem>();
+	if (Subsystem && !Subsystem->ConsumeOperationBudget(GetOwner()->GetNetConnection()))
 	{
 		return;
 	}
 
-	ACharacter* const Character = Cast<ACharacter>(GetOwner());
-
-	if (Character == nullptr || Character->GetController() == nullptr)
+	if (m_ItemSubsystem == nullptr || m_ItemSubsystem->GetRegistryVersion() <= KnownVersion)
 	{
-		LOG("Character is null or Controller is null");
 		return;
 	}
 
-	FVector CameraLocation;
-	FRotator CameraRotation;
-	Character->GetController()->GetPlayerViewPoint(CameraLocation, CameraRotation);
+	TArray<FInventoryItem> Items;
+	TArray<FName> RemovedItems;
+	m_ItemSubsystem->GetChangedDefinitions(Items, RemovedItems);
 
-	FVector EndLocation = CameraLocation + (CameraRotation.Vector() * 150.0f);
+	if (Items.Num() > 0 || RemovedItems.Num() > 0)
+	{
+		SendItemDefinitions(m_ItemSubsystem->GetRegistryVersion(), Items, RemovedItems);
+	}
+}
 
-	FActorSpawnParameters SpawnParams;
-	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
-	SpawnParams.Owner = GetOwner();
-	SpawnParams.Instigator = Character;
+void UInventoryComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	FInventoryItemStack& Item = m_InventoryItems[ItemIndex];
-	int32 DroppedAmount = Item.StackSize;
+	DOREPLIFETIME(UInventoryComponent, m_InventoryItems); // TODO: Possibly owner only?
+	DOREPLIFETIME(UInventoryComponent, m_InstanceData);
+	DOREPLIFETIME_CONDITION(UInventoryComponent, m_Cooldowns, COND_OwnerOnly);
+	DOREPLIFETIME_CONDITION(UInventoryComponent, m_ActiveCast, COND_OwnerOnly);
+	DOREPLIFETIME_CONDITION(UInventoryComponent, m_BagWeight, COND_OwnerOnly);
+	DOREPLIFETIME_CONDITION(UInventoryComponent, m_EncumbranceLevel, COND_OwnerOnly);
+}
 
-	AInventoryBaseItem* const SpawnedActor = GetWorld()->SpawnActor<AInventoryBaseItem>(Item.InventoryItem.ObjectClass, UKismetMathLibrary::MakeTransform(EndLocation, {}, { 1.0f, 1.0f, 1.0f }), SpawnParams);
-	if (SpawnedActor)
+void UInventoryComponent::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
+{
+	Super::PreReplication(ChangedPropertyTracker);
+
+	DOREPLIFETIME_ACTIVE_OVERRIDE(UInventoryComponent, m_InventoryItems, m_bReplicateSlots);
+}
+
+void UInventoryComponent::OnRep_InventoryItems()
+{
+	const int32 OldNum = m_SeenSlotVersions.Num();
+	m_SeenSlotVersions.SetNum(m_InventoryItems.Num());
+
+	for (int32 i = OldNum; i < m_SeenSlotVersions.Num(); i++)
 	{
-		// NOTE: required to enable physics on the mesh in the actor (if any) so the actor doesn't just hover in the level
+		m_SeenSlotVersions[i] = INDEX_NONE;
+	}
 
-		RemoveItemBySlot(ItemIndex);
-		//RemoveItem(Item);
+	bool bChanged = false;
 
-		FInventoryItemMeta& NewMeta = SpawnedActor->GetInventoryItemMeta();
-		NewMeta.Quantity = DroppedAmount;
-		SpawnedActor->SetInventoryItemMeta(NewMeta);
+	// Only notify the slots that actually changed so widgets don't have to poll the array
+	for (int32 i = 0; i < m_InventoryItems.Num(); i++)
+	{
+		if (m_SeenSlotVersions[i] != m_InventoryItems[i].Version)
+		{
+			// Only the row name of table items is sent
+			ResolveItem(m_InventoryItems[i]);
+
+			m_SeenSlotVersions[i] = m_InventoryItems[i].Version;
+			OnSlotChanged.Broadcast(i);
+			bChanged = true;
+		}
+	}
+
+	if (bChanged)
+	{
+		RebuildSlotIndex();
+		OnInventoryChanged.Broadcast();
+	}
 
-		OnItemDropped.Broadcast(GetOwner(), FInventoryItemStack(Item.InventoryItem, DroppedAmount));
+	if (m_PredictedSlots.Num() > 0)
+	{
+		PrunePredictions();
 	}
 }
 
-void UInventoryComponent::AddItem(const FInventoryItemStack& ItemToAdd)
+void UInventoryComponent::SetSlot(int32 Index, const FInventoryItemStack& NewStack)
 {
-	if (IsInventoryFull())
+	if (!m_InventoryItems.IsValidIndex(Index))
 	{
-		PRINT("Your inventory is full!");
 		return;
 	}
 
-	// Get the next available empty slot to put this item
-	int32 slot = GetNextEmptySlot();
+	const bool bAuthority = GetOwnerRole() == ROLE_Authority;
 
-	// Check if the item can be auto stacked and if it can stack at all
-	if (ItemToAdd.InventoryItem.bAutoStack && ItemToAdd.InventoryItem.CanStack())
+	// Anything happening to the item being cast interrupts it
+	if (bAuthority && m_ActiveCast.SlotIndex == Index)
 	{
-		int32 ItemStackSize = ItemToAdd.StackSize;
+		InterruptCast();
+	}
 
-		for (FInventoryItemStack& item : m_InventoryItems)
-		{
-			// TODO: Fix if we drop x items as a stack and it doesn't allow stacking or the MaxStackSize is > then we still pick up all of the stack and not as multiple stacks
-			// (ie MaxStackSize == 0 and ItemDropped = 2, we pick up ItemDropped in 1 slot instead of 2)
-			if (item == ItemToAdd && item.StackSize < item.InventoryItem.MaxStackSize)
-			{
-				// Get the amount to add based on how many the stack allows
-				int32 ItemCountToAdd = FMath::Min<int32>(ItemStackSize, item.InventoryItem.MaxStackSize - item.StackSize);
+	if (bAuthority)
+	{
+		UpdateHeldClass(m_InventoryItems[Index], -1);
+		UpdateHeldClass(NewStack, 1);
+		UnindexSlot(Index);
 
-				// Update the new count on the stack
-				item.StackSize += ItemCountToAdd;
+		if (!m_InventoryItems[Index].IsEmptySlot())
+		{
+			OnItemTotalChanged(m_InventoryItems[Index].InventoryItem.GetKey(), -m_InventoryItems[Index].StackSize, -m_InventoryItems[Index].GetWeight());
+		}
 
-				// Remove the count of this item so we can create another stack if necessary
-				ItemStackSize -= ItemCountToAdd;
+		// The instance may just be moving to another slot, check once the move is done
+		if (m_InventoryItems[Index].HasInstanceData() && m_InventoryItems[Index].InstanceID != NewStack.InstanceID)
+		{
+			m_OrphanedInstances.Add(m_InventoryItems[Index].InstanceID);
 
-				if (ItemStackSize <= 0)
-				{
-					break;
-				}
+			if (!m_bPruneInstancesPending)
+			{
+				m_bPruneInstancesPending = true;
+				GetWorld()->GetTimerManager().SetTimerForNextTick(this, &UInventoryComponent::PruneInstanceData);
 			}
 		}
+	}
+
+	// Keep the slot's own version so it only ever increases, no matter where the new stack came from
+	const int32 Version = m_InventoryItems[Index].Version;
+
+	m_InventoryItems[Index] = NewStack;
+	m_InventoryItems[Index].Version = Version;
+
+	// Stacks start decaying when they first go into an inventory
+	if (bAuthority && m_InventoryItems[Index].ConditionTime < 0.0f && m_InventoryItems[Index].InventoryItem.HasCondition())
+	{
+		m_InventoryItems[Index].ConditionTime = GetInventoryTime();
+	}
 
-		// If the stack size is greater than 0 then insert the stack where the empty slot is
-		if (ItemStackSize > 0)
+	if (bAuthority)
+	{
+		IndexSlot(Index);
+
+		// Batches re-check the recipes and weight once when they close, so items passing through 0 don't flip them back and forth
+		if (m_ChangeBatchDepth == 0)
 		{
-			FInventoryItemStack st = ItemToAdd;
-			st.StackSize = ItemStackSize;
+			UpdateCraftableRecipes();
+			UpdateEncumbrance();
+		}
 
-			m_InventoryItems[slot] = st;
+		if (!m_InventoryItems[Index].IsEmptySlot())
+		{
+			OnItemTotalChanged(m_InventoryItems[Index].InventoryItem.GetKey(), m_InventoryItems[Index].StackSize, m_InventoryItems[Index].GetWeight());
 		}
 	}
-	else
+
+	MarkSlotDirty(Index);
+
+	if (bAuthority)
 	{
-		// The item isn't stackable on pickup so just add it to the empty slot
-		m_InventoryItems[slot] = ItemToAdd;
+		ScheduleExpiry(Index);
 	}
 }
 
-int32 UInventoryComponent::RemoveItem(const FInventoryItemStack& ItemToRemove)
+void UInventoryComponent::PruneInstanceData()
 {
-	int32 ItemStackSize = ItemToRemove.StackSize;
+	m_bPruneInstancesPending = false;
 
-	for (FInventoryItemStack& item : m_InventoryItems)
+	for (const FInventoryItemStack& Stack : m_InventoryItems)
 	{
-		if (item == ItemToRemove)
-		{
-			// TODO: This shouldn't drop all, but rather allow a quantity to be dropped
-			int32 ItemCountToRemove = FMath::Min<int32>(ItemStackSize, item.StackSize);
-
-			item.StackSize -= ItemCountToRemove;
-
-			ItemStackSize -= ItemCountToRemove;
+		m_OrphanedInstances.Remove(Stack.InstanceID);
+	}
 
-			if (item.StackSize <= 0)
-			{
-				m_InventoryItems[GetItemIndex(item)] = FInventoryItemStack();
-				// PRINT("DROPPED BOI");
-			}
+	// Spilling a bag writes slots, which can orphan more instances
+	const TSet<int32> Orphaned = MoveTemp(m_OrphanedInstances);
+	m_OrphanedInstances.Reset();
 
-			if (ItemStackSize <= 0)
-			{
-				break;
-			}
+	for (int32 InstanceID : Orphaned)
+	{
+		// A bag that couldn't be emptied keeps its data and is tried again the next time instances are pruned
+		if (SpillBag(InstanceID))
+		{
+			m_InstanceData.Remove(InstanceID);
+		}
+		else
+		{
+			m_OrphanedInstances.Add(InstanceID);
 		}
 	}
-
-	return ItemToRemove.StackSize - ItemStackSize;
 }
 
-FInventoryItemStack UInventoryComponent::RemoveItemBySlot(int32 SlotID)
+FInventoryInstanceData* UInventoryComponent::GetOrCreateInstanceData(int32 SlotIndex)
 {
-	if (m_InventoryItems.IsValidIndex(SlotID))
+	if (GetOwnerRole() != ROLE_Authority || !m_InventoryItems.IsValidIndex(SlotIndex) || m_InventoryItems[SlotIndex].IsEmptySlot())
 	{
-		FInventoryItemStack& TmpItem = m_InventoryItems[SlotID];
+		return nullptr;
+	}
 
-		m_InventoryItems[SlotID] = FInventoryItemStack();
+	if (!m_InventoryItems[SlotIndex].HasInstanceData())
+	{
+		UInventorySubsystem* const Subsystem = GetWorld()->GetSubsystem<UInventorySubsystem>();
+		if (Subsystem == nullptr)
+		{
+			return nullptr;
+		}
 
-		return TmpItem;
+		FInventoryItemStack Stack = m_InventoryItems[SlotIndex];
+		Stack.InstanceID = Subsystem->AllocateInstanceID();
+		SetSlot(SlotIndex, Stack);
 	}
 
-	return FInventoryItemStack();
+	return &m_InstanceData.FindOrAdd(m_InventoryItems[SlotIndex].InstanceID);
 }
 
-void UInventoryComponent::ExecItem(const FInventoryItemStack& Item)
+const FInventoryInstanceData* UInventoryComponent::FindInstanceData(int32 InstanceID) const
 {
-	Server_ExecItem(Item);
+	return m_InstanceData.Find(InstanceID);
 }
 
-bool UInventoryComponent::Server_ExecItem_Validate(const FInventoryItemStack& Item) { return true; }
-void UInventoryComponent::Server_ExecItem_Implementation(const FInventoryItemStack& Item)
+bool UInventoryComponent::GetInstanceData(int32 SlotIndex, FInventoryInstanceData& OutData) const
 {
-	OnItemExec.Broadcast(GetOwner(), Item, Item.InventoryItem.ItemAction);
-}
+	const FInventoryInstanceData* const Data = m_InventoryItems.IsValidIndex(SlotIndex) ? m_InstanceData.Find(m_InventoryItems[SlotIndex].InstanceID) : nullptr;
+	if (Data == nullptr)
+	{
+		return false;
+	}
 
-void UInventoryComponent::SwapItem(int32 CurrentIndex, int32 NewIndex)
-{
-	Server_SwapItem(CurrentIndex, NewIndex);
+	OutData = *Data;
+	return true;
 }
 
-bool UInventoryComponent::Server_SwapItem_Validate(int32 CurrentIndex, int32 NewIndex) { return true; }
-void UInventoryComponent::Server_SwapItem_Implementation(int32 CurrentIndex, int32 NewIndex)
+float UInventoryComponent::GetInstanceProperty(int32 SlotIndex, FName Name, float DefaultValue) const
 {
-	// If the 2 items in each index are the same and can stack then stack them, else don't swap (unless the health of the item is different etc)
+	const FInventoryInstanceData* const Data = m_InventoryItems.IsValidIndex(SlotIndex) ? m_InstanceData.Find(m_InventoryItems[SlotIndex].InstanceID) : nullptr;
+	const FInventoryInstanceProperty* const Property = Data ? Data->FindProperty(Name) : nullptr;
 
-	PRINT("Swapped items");
-	m_InventoryItems.Swap(CurrentIndex, NewIndex);
-	// m_InventoryItems[CurrentIndex] = FInventoryItemStack();
-
-	OnItemMoved.Broadcast(GetOwner(), m_InventoryItems[CurrentIndex], CurrentIndex, NewIndex);
+	return Property ? Property->Value : DefaultValue;
 }
 
-int32 UInventoryComponent::GetNextEmptySlot()
+void UInventoryComponent::SetInstanceProperty(int32 SlotIndex, FName Name, float Value)
 {
-	/*FInventoryItemStack* item = m_InventoryItems.FindByPredicate([](const FInventoryItemStack& Item)
-	{
-		return Item.IsEmptySlot() ? Item : FInventoryItemStack();
-	});
-
-	return GetItemIndex(*item);*/
-
-	/*if (m_InventoryItems.Num() >= GetTotalInventorySlotCount())
-	{
-		PRINT("You have too many slots in your inventory array!");
-		return -1;
-	}*/
-
-	for (int32 i = 0; i < m_InventoryItems.Num(); i++)
+	if (FInventoryInstanceData* const Data = GetOrCreateInstanceData(SlotIndex))
 	{
-		if (m_InventoryItems.IsValidIndex(i) && m_InventoryItems[i].IsEmptySlot())
+		if (FInventoryInstanceProperty* const Property = Data->FindProperty(Name))
 		{
-			return i;
+			Property->Value = Value;
+		}
+		else
+		{
+			Data->Properties.Emplace(Name, Value);
 		}
-	}
 
-	return -1;
+		m_InstanceData.MarkItemDirty(*Data);
+		OnInstanceDataChanged.Broadcast(Data->InstanceID);
+	}
 }
 
-void UInventoryComponent::SplitItemStack(const FInventoryItemStack& Item, int32 NewStackSize)
+void UInventoryComponent::AddInstanceTag(int32 SlotIndex, FName Tag)
 {
-	Server_SplitItemStack(Item, NewStackSize);
+	if (FInventoryInstanceData* const Data = GetOrCreateInstanceData(SlotIndex))
+	{
+		Data->Tags.AddUnique(Tag);
+
+		m_InstanceData.MarkItemDirty(*Data);
+		OnInstanceDataChanged.Broadcast(Data->InstanceID);
+	}
 }
 
-bool UInventoryComponent::Server_SplitItemStack_Validate(const FInventoryItemStack& Item, int32 NewStackSize) { return true; }
-void UInventoryComponent::Server_SplitItemStack_Implementation(const FInventoryItemStack& Item, int32 NewStackSize)
+void UInventoryComponent::RemoveInstanceTag(int32 SlotIndex, FName Tag)
 {
+	FInventoryInstanceData* const Data = m_InventoryItems.IsValidIndex(SlotIndex) ? m_InstanceData.Find(m_InventoryItems[SlotIndex].InstanceID) : nullptr;
 
+	if (GetOwnerRole() == ROLE_Authority && Data && Data->Tags.Remove(Tag) > 0)
+	{
+		m_InstanceData.MarkItemDirty(*Data);
+		OnInstanceDataChanged.Broadcast(Data->InstanceID);
+	}
 }
 
-int32 UInventoryComponent::GetCountOfItem(const FInventoryItem& Item)
+void UInventoryComponent::ScheduleExpiry(int32 Index)
 {
-	int32 count = 0;
+	const FInventoryItemStack& Stack = m_InventoryItems[Index];
+	const float ExpiryTime = Stack.IsEmptySlot() ? -1.0f : Stack.GetExpiryTime();
 
-	// TODO: Update this with a better algo as this is VERY slow
-	// https://www.geeksforgeeks.org/count-number-of-occurrences-or-frequency-in-a-sorted-array/
-	for (FInventoryItemStack& item : m_InventoryItems)
+	if (ExpiryTime >= 0.0f)
 	{
-		if (item.InventoryItem == Item)
+		if (UInventorySubsystem* const Subsystem = GetWorld()->GetSubsystem<UInventorySubsystem>())
 		{
-			count++;
+			Subsystem->ScheduleTimer(this, EInventoryTimer::Expiry, Index, Stack.Version, ExpiryTime);
 		}
 	}
-
-	return count;
 }
 
-void UInventoryComponent::CombineItemStack(int32 ItemToCombine, int32 TargetItem)
+void UInventoryComponent::OnInventoryTimer(EInventoryTimer Type, int32 SlotIndex, int32 Key)
 {
-	Server_CombineItemStack(ItemToCombine, TargetItem);
+	if (Type == EInventoryTimer::Cooldown)
+	{
+		PruneCooldowns(GetInventoryTime());
+		return;
+	}
+
+	if (Type == EInventoryTimer::Cast)
+	{
+		// Stale if the cast was interrupted or replaced
+		if (m_ActiveCast.Serial == Key && m_ActiveCast.SlotIndex == SlotIndex)
+		{
+			m_ActiveCast = FInventoryCast();
+			CompleteExec(SlotIndex, GetInventoryTime());
+		}
+
+		return;
+	}
+
+	// Stale if the slot has changed since, the change scheduled its own timer
+	if (!m_InventoryItems.IsValidIndex(SlotIndex) || m_InventoryItems[SlotIndex].Version != Key || m_InventoryItems[SlotIndex].IsEmptySlot())
+	{
+		return;
+	}
+
+	if (m_InventoryItems[SlotIndex].GetCondition(GetInventoryTime()) <= 0.0f)
+	{
+		ExpireSlot(SlotIndex);
+	}
+	else
+	{
+		ScheduleExpiry(SlotIndex);
+	}
+}
+
+void UInventoryComponent::ExpireSlot(int32 SlotIndex)
+{
+	const FInventoryItemStack Expired = m_InventoryItems[SlotIndex];
+
+	const FInventoryItem* const Replacement = Expired.InventoryItem.ExpiredItemRowName.IsNone() ? nullptr : FindItemData(Expired.InventoryItem.ExpiredItemRowName);
+	if (!ReplaceSlot(SlotIndex, Replacement ? FInventoryItemStack(*Replacement, Expired.StackSize) : FInventoryItemStack()))
+	{
+		return;
+	}
+
+	OnItemExpired.Broadcast(GetOwner(), Expired);
+}
+
+bool UInventoryComponent::ReplaceSlot(int32 Index, const FInventoryItemStack& NewStack)
+{
+	if (NewStack.IsEmptySlot() || !IsGridSlot(Index))
+	{
+		SetSlot(Index, NewStack);
+		return true;
+	}
+
+	const FInventoryItemStack OldStack = m_InventoryItems[Index];
+
+	// Keep it where it is and the same way round if the new footprint allows it
+	FInventoryItemStack Placed = NewStack;
+	Placed.bRotated = m_InventoryItems[Index].bRotated && Placed.InventoryItem.bCanRotate;
+
+	if (CanPlaceAt(Index, Placed))
+	{
+		SetSlot(Index, Placed);
+		return true;
+	}
+
+	FInventoryChangeBatch Batch(this);
+
+	// The old footprint would be in the way of finding room for the new one
+	SetSlot(Index, FInventoryItemStack());
+
+	const int32 Slot = FindSlotFor(Placed);
+	if (Slot != INDEX_NONE)
+	{
+		SetSlot(Slot, Placed);
+		return true;
+	}
+
+	if (SpawnOrQueueDrop(Placed))
+	{
+		LOG("There's no room left for %s, dropping it", *Placed.InventoryItem.ID.ToString());
+		return true;
+	}
+
+	// The old footprint still fits where it was, keep it rather than lose the stack
+	LOG("There's no room left for %s and it can't be dropped, keeping the old stack", *Placed.InventoryItem.ID.ToString());
+	SetSlot(Index, OldStack);
+
+	return false;
+}
+
+float UInventoryComponent::GetInventoryTime() const
+{
+	const UWorld* const World = GetWorld();
+	if (World == nullptr)
+	{
+		return 0.0f;
+	}
+
+	// Clients use the server's clock so the condition they show matches the server
+	const AGameStateBase* const GameState = World->GetGameState();
+	return GameState ? GameState->GetServerWorldTimeSeconds() : World->GetTimeSeconds();
+}
+
+float UInventoryComponent::GetSlotCondition(int32 SlotIndex) const
+{
+	const FInventoryItemStack& Stack = GetDisplayedSlot(SlotIndex);
+	return Stack.IsEmptySlot() ? 0.0f : Stack.GetCondition(GetInventoryTime());
+}
+
+void UInventoryComponent::MarkSlotDirty(int32 Index)
+{
+	if (!m_InventoryItems.IsValidIndex(Index))
+	{
+		return;
+	}
+
+	m_InventoryItems[Index].Version++;
+	MarkSnapshotDirty(Index);
+
+	OnSlotChanged.Broadcast(Index);
+
+	if (m_ChangeBatchDepth > 0)
+	{
+		m_bChangedInBatch = true;
+	}
+	else
+	{
+		OnInventoryChanged.Broadcast();
+	}
+}
+
+void UInventoryComponent::ReceiveSlot(int32 Index, const FInventoryItemStack& Stack)
+{
+	if (!m_InventoryItems.IsValidIndex(Index))
+	{
+		return;
+	}
+
+	UnindexSlot(Index);
+	m_InventoryItems[Index] = Stack;
+	ResolveItem(m_InventoryItems[Index]);
+	IndexSlot(Index);
+
+	OnSlotChanged.Broadcast(Index);
+}
+
+void UInventoryComponent::IndexSlot(int32 Index)
+{
+	const FInventoryItemStack& Stack = m_InventoryItems[Index];
+
+	MarkSnapshotDirty(Index);
+
+	if (Stack.IsEmptySlot())
+	{
+		m_EmptySlotCount++;
+		return;
+	}
+
+	if (IsGridSlot(Index))
+	{
+		MarkFootprint(m_Grid, Index, Stack, true);
+	}
+
+	const FName Key = Stack.InventoryItem.GetKey();
+
+	m_ItemTotals.FindOrAdd(Key) += Stack.StackSize;
+	m_TotalWeight += Stack.GetWeight();
+	m_DirtyTotals.Add(Key);
+
+	if (Stack.InventoryItem.CanStack() && Stack.GetEmptySizeLeft() > 0 && !Stack.HasInstanceData())
+	{
+		m_PartialStacks.FindOrAdd(Key).AddUnique(Index);
+	}
+}
+
+void UInventoryComponent::UnindexSlot(int32 Index)
+{
+	const FInventoryItemStack& Stack = m_InventoryItems[Index];
+
+	if (Stack.IsEmptySlot())
+	{
+		m_EmptySlotCount--;
+		return;
+	}
+
+	if (IsGridSlot(Index))
+	{
+		MarkFootprint(m_Grid, Index, Stack, false);
+	}
+
+	const FName Key = Stack.InventoryItem.GetKey();
+
+	m_TotalWeight -= Stack.GetWeight();
+
+	if (int32* const Total = m_ItemTotals.Find(Key))
+	{
+		*Total -= Stack.StackSize;
+
+		if (*Total <= 0)
+		{
+			m_ItemTotals.Remove(Key);
+		}
+	}
+
+	m_DirtyTotals.Add(Key);
+
+	if (TArray<int32>* Slots = m_PartialStacks.Find(Key))
+	{
+		Slots->RemoveSingleSwap(Index);
+
+		if (Slots->Num() == 0)
+		{
+			m_PartialStacks.Remove(Key);
+		}
+	}
+}
+
+void UInventoryComponent::MarkSnapshotDirty(int32 Index)
+{
+	if (Index == INDEX_NONE)
+	{
+		m_bSnapshotAllDirty = true;
+	}
+	else
+	{
+		const int32 Block = Index / FInventorySnapshot::SlotsPerBlock;
+		while (m_DirtySnapshotBlocks.Num() <= Block)
+		{
+			m_DirtySnapshotBlocks.Add(false);
+		}
+
+		m_DirtySnapshotBlocks[Block] = true;
+	}
+
+	if (m_bSnapshotDirty)
+	{
+		return;
+	}
+
+	UInventorySubsystem* const Subsystem = GetWorld() ? GetWorld()->GetSubsystem<UInventorySubsystem>() : nullptr;
+	if (Subsystem)
+	{
+		m_bSnapshotDirty = true;
+		Subsystem->QueueSnapshot(this);
+	}
+}
+
+void UInventoryComponent::PublishSnapshot()
+{
+	check(IsInGameThread());
+
+	if (!m_bSnapshotDirty)
+	{
+		return;
+	}
+
+	m_bSnapshotDirty = false;
+
+	// Only the game thread swaps m_Snapshot so reading it here doesn't need the lock
+	const FInventorySnapshotPtr Previous = m_Snapshot;
+	const bool bShareBlocks = !m_bSnapshotAllDirty && Previous.IsValid() && Previous->NumSlots == m_InventoryItems.Num();
+
+	// A new snapshot every time, readers may still be holding the old one. Blocks without a changed slot are shared with it
+	TSharedPtr<FInventorySnapshot, ESPMode::ThreadSafe> Snapshot = MakeShared<FInventorySnapshot, ESPMode::ThreadSafe>();
+	Snapshot->NumSlots = m_InventoryItems.Num();
+	Snapshot->SlotBlocks.Reserve(FMath::DivideAndRoundUp(Snapshot->NumSlots, FInventorySnapshot::SlotsPerBlock));
+
+	for (int32 First = 0, Block = 0; First < Snapshot->NumSlots; First += FInventorySnapshot::SlotsPerBlock, Block++)
+	{
+		const bool bBlockDirty = m_DirtySnapshotBlocks.IsValidIndex(Block) && m_DirtySnapshotBlocks[Block];
+		if (bShareBlocks && !bBlockDirty)
+		{
+			Snapshot->SlotBlocks.Add(Previous->SlotBlocks[Block]);
+		}
+		else
+		{
+			const int32 Count = FMath::Min(FInventorySnapshot::SlotsPerBlock, Snapshot->NumSlots - First);
+			Snapshot->SlotBlocks.Add(MakeShared<TArray<FInventoryItemStack>, ESPMode::ThreadSafe>(m_InventoryItems.GetData() + First, Count));
+		}
+	}
+
+	m_DirtySnapshotBlocks.Init(false, Snapshot->SlotBlocks.Num());
+	m_bSnapshotAllDirty = false;
+
+	Snapshot->ItemTotals = m_ItemTotals;
+	Snapshot->Weight = GetTotalWeight(true);
+	Snapshot->Frame = GFrameCounter;
+
+	FScopeLock Lock(&m_SnapshotLock);
+	Snapshot->Serial = Previous.IsValid() ? Previous->Serial + 1 : 1;
+	m_Snapshot = Snapshot;
+}
+
+FInventorySnapshotPtr UInventoryComponent::GetSnapshot() const
+{
+	// Only copying the pointer is locked, the snapshot itself is never written again
+	FScopeLock Lock(&m_SnapshotLock);
+	return m_Snapshot;
+}
+
+void UInventoryComponent::RebuildSlotIndex()
+{
+	// Every item that was held may have changed
+	for (const TPair<FName, int32>& Total : m_ItemTotals)
+	{
+		m_DirtyTotals.Add(Total.Key);
+	}
+
+	m_PartialStacks.Reset();
+	m_ItemTotals.Reset();
+	m_EmptySlotCount = 0;
+	m_TotalWeight = 0.0f;
+
+	MarkSnapshotDirty();
+
+	if (m_bUseFootprints)
+	{
+		m_Grid.Reset(m_InventoryRowsNum, m_InventoryColumnsNum);
+	}
+
+	for (int32 i = 0; i < m_InventoryItems.Num(); i++)
+	{
+		IndexSlot(i);
+	}
+
+	UpdateCraftableRecipes();
+	UpdateEncumbrance();
+}
+
+void UInventoryComponent::MarkFootprint(FInventoryGrid& Grid, int32 Index, const FInventoryItemStack& Stack, bool bTaken) const
+{
+	const FIntPoint Size = Stack.GetFootprint();
+	Grid.Set(Index / m_InventoryColumnsNum, Index % m_InventoryColumnsNum, Size.X, Size.Y, bTaken);
+}
+
+bool UInventoryComponent::FitsInGrid(const TArray<TPair<int32, FInventoryItemStack>>& Placements, int32 IgnoreA, int32 IgnoreB) const
+{
+	if (!m_bUseFootprints)
+	{
+		return true;
+	}
+
+	FInventoryGrid Grid = m_Grid;
+
+	for (int32 Ignored : { IgnoreA, IgnoreB })
+	{
+		if (IsGridSlot(Ignored) && !m_InventoryItems[Ignored].IsEmptySlot())
+		{
+			MarkFootprint(Grid, Ignored, m_InventoryItems[Ignored], false);
+		}
+	}
+
+	for (const TPair<int32, FInventoryItemStack>& Placement : Placements)
+	{
+		if (Placement.Value.IsEmptySlot() || !IsGridSlot(Placement.Key))
+		{
+			continue;
+		}
+
+		const FIntPoint Size = Placement.Value.GetFootprint();
+		const int32 Row = Placement.Key / m_InventoryColumnsNum;
+		const int32 Column = Placement.Key % m_InventoryColumnsNum;
+
+		if (!Grid.Fits(Row, Column, Size.X, Size.Y))
+		{
+			return false;
+		}
+
+		Grid.Set(Row, Column, Size.X, Size.Y, true);
+	}
+
+	return true;
+}
+
+int32 UInventoryComponent::FindSlotFor(FInventoryItemStack& Stack) const
+{
+	Stack.bRotated = false;
+
+	if (m_bUseFootprints)
+	{
+		int32 Row = 0;
+		int32 Column = 0;
+
+		const FIntPoint Size = Stack.GetFootprint();
+
+		bool bFound = m_Grid.FindFirstFit(Size.X, Size.Y, Row, Column);
+		if (!bFound && Stack.InventoryItem.bCanRotate && Size.X != Size.Y)
+		{
+			bFound = m_Grid.FindFirstFit(Size.Y, Size.X, Row, Column);
+			Stack.bRotated = bFound;
+		}
+
+		if (bFound)
+		{
+			return Row * m_InventoryColumnsNum + Column;
+		}
+	}
+
+	// Without footprints every slot holds anything, with them only the action bar is left
+	for (int32 i = m_bUseFootprints ? GetInventorySlotsCount() : 0; i < m_InventoryItems.Num(); i++)
+	{
+		if (m_InventoryItems[i].IsEmptySlot())
+		{
+			return i;
+		}
+	}
+
+	return INDEX_NONE;
+}
+
+bool UInventoryComponent::CanPlaceAt(int32 SlotIndex, const FInventoryItemStack& Stack) const
+{
+	if (!m_InventoryItems.IsValidIndex(SlotIndex))
+	{
+		return false;
+	}
+
+	TArray<TPair<int32, FInventoryItemStack>> Placements;
+	Placements.Emplace(SlotIndex, Stack);
+
+	return (m_bUseFootprints || m_InventoryItems[SlotIndex].IsEmptySlot()) && FitsInGrid(Placements, SlotIndex);
+}
+
+void UInventoryComponent::UpdateCraftableRecipes()
+{
+	if (m_DirtyTotals.Num() == 0)
+	{
+		return;
+	}
+
+	if (m_CraftingSubsystem == nullptr || m_CraftingSubsystem->GetRecipeCount() == 0)
+	{
+		m_DirtyTotals.Reset();
+		return;
+	}
+
+	const int32 RecipeCount = m_CraftingSubsystem->GetRecipeCount();
+	if (m_CraftableRecipes.Num() != RecipeCount)
+	{
+		m_CraftableRecipes.Init(false, RecipeCount);
+	}
+
+	bool bChanged = false;
+
+	// Only the recipes that use an item whose total changed
+	TBitArray<> Checked(false, RecipeCount);
+
+	for (const FName& Key : m_DirtyTotals)
+	{
+		const TArray<int32>* const Recipes = m_CraftingSubsystem->GetRecipesUsing(Key);
+		if (Recipes == nullptr)
+		{
+			continue;
+		}
+
+		for (int32 RecipeIndex : *Recipes)
+		{
+			if (Checked[RecipeIndex])
+			{
+				continue;
+			}
+
+			Checked[RecipeIndex] = true;
+
+			const bool bCraftable = m_CraftingSubsystem->GetRecipe(RecipeIndex)->HasInputs(m_ItemTotals);
+			if (m_CraftableRecipes[RecipeIndex] != bCraftable)
+			{
+				m_CraftableRecipes[RecipeIndex] = bCraftable;
+				bChanged = true;
+			}
+		}
+	}
+
+	m_DirtyTotals.Reset();
+
+	if (bChanged)
+	{
+		OnCraftableRecipesChanged.Broadcast();
+	}
+}
+
+int32 UInventoryComponent::GetItemTotal(FName ItemID, bool bIncludeBags) const
+{
+	PrepareSlots();
+
+	const int32* const Total = m_ItemTotals.Find(ItemID);
+	const int32* const BagTotal = bIncludeBags ? m_BagTotals.Find(ItemID) : nullptr;
+
+	return (Total ? *Total : 0) + (BagTotal ? *BagTotal : 0);
+}
+
+TArray<FName> UInventoryComponent::SearchItems(const FString& Text) const
+{
+	PrepareSlots();
+
+	TArray<FName> Items;
+
+	TBitArray<> Matches;
+	const FInventorySearchIndex* const SearchIndex = m_ItemSubsystem ? &m_ItemSubsystem->GetSearchIndex() : nullptr;
+	const bool bFiltered = SearchIndex && SearchIndex->Search(Text, Matches);
+
+	// Only the items that are held, which is far fewer than the items that match
+	for (const TPair<FName, int32>& Total : m_ItemTotals)
+	{
+		const int32 ItemIndex = bFiltered ? SearchIndex->FindItem(Total.Key) : INDEX_NONE;
+
+		if (!bFiltered || (ItemIndex != INDEX_NONE && Matches[ItemIndex]))
+		{
+			Items.Add(Total.Key);
+		}
+	}
+
+	return Items;
+}
+
+TArray<int32> UInventoryComponent::GetSlotsMatching(const FString& Text) const
+{
+	TSet<FName, DefaultKeyFuncs<FName>, TInlineSetAllocator<32>> Items;
+	Items.Append(SearchItems(Text));
+
+	TArray<int32> Slots;
+
+	for (int32 i = 0; i < m_InventoryItems.Num() && Items.Num() > 0; i++)
+	{
+		const FInventoryItemStack& Stack = GetDisplayedSlot(i);
+
+		if (!Stack.IsEmptySlot() && Items.Contains(Stack.InventoryItem.GetKey()))
+		{
+			Slots.Add(i);
+		}
+	}
+
+	return Slots;
+}
+
+float UInventoryComponent::GetTotalWeight(bool bIncludeBags) const
+{
+	return bIncludeBags ? m_TotalWeight + m_BagWeight : m_TotalWeight;
+}
+
+float UInventoryComponent::GetWeightLeft() const
+{
+	return m_MaxWeight > 0.0f ? FMath::Max(0.0f, m_MaxWeight - GetTotalWeight()) : MAX_flt;
+}
+
+int32 UInventoryComponent::GetCountWithinWeight(const FInventoryItem& Item, int32 Count) const
+{
+	if (Item.Weight <= 0.0f)
+	{
+		return Count;
+	}
+
+	const float WeightLeft = GetWeightLeft();
+	if (WeightLeft >= MAX_flt)
+	{
+		return Count;
+	}
+
+	// A little slack so adding up floats doesn't turn away the last item that exactly fits
+	const float Fits = FMath::FloorToFloat((WeightLeft + KINDA_SMALL_NUMBER) / Item.Weight);
+	return Fits < Count ? (int32)Fits : Count;
+}
+
+void UInventoryComponent::UpdateEncumbrance()
+{
+	if (GetOwnerRole() != ROLE_Authority)
+	{
+		return;
+	}
+
+	const float Weight = GetTotalWeight();
+
+	int32 Level = 0;
+	for (float Threshold : m_EncumbranceThresholds)
+	{
+		Level += Weight >= Threshold ? 1 : 0;
+	}
+
+	if (Level == m_EncumbranceLevel)
+	{
+		return;
+	}
+
+	const uint8 OldLevel = m_EncumbranceLevel;
+	m_EncumbranceLevel = (uint8)FMath::Min(Level, 255);
+
+	OnEncumbranceChanged.Broadcast(m_EncumbranceLevel, OldLevel);
+}
+
+void UInventoryComponent::OnRep_EncumbranceLevel(uint8 OldLevel)
+{
+	OnEncumbranceChanged.Broadcast(m_EncumbranceLevel, OldLevel);
+}
+
+UInventoryBagComponent* UInventoryComponent::OpenBag(int32 SlotIndex)
+{
+	if (GetOwnerRole() != ROLE_Authority || !CanHoldBags() || !m_InventoryItems.IsValidIndex(SlotIndex) || m_InventoryItems[SlotIndex].IsEmptySlot() || !m_InventoryItems[SlotIndex].InventoryItem.IsBag())
+	{
+		return nullptr;
+	}
+
+	UInventoryBagComponent* Bag = GetBag(SlotIndex);
+
+	if (Bag == nullptr)
+	{
+		// The bag is found by its instance ID wherever the stack moves
+		if (GetOrCreateInstanceData(SlotIndex) == nullptr)
+		{
+			return nullptr;
+		}
+
+		Bag = CreateBag(m_InventoryItems[SlotIndex].InstanceID, m_InventoryItems[SlotIndex].InventoryItem.BagSlots);
+	}
+
+	Bag->OpenContainer();
+
+	return Bag;
+}
+
+void UInventoryComponent::CloseBag(int32 SlotIndex)
+{
+	if (UInventoryBagComponent* const Bag = GetOwnerRole() == ROLE_Authority ? GetBag(SlotIndex) : nullptr)
+	{
+		Bag->CloseContainer();
+	}
+}
+
+UInventoryBagComponent* UInventoryComponent::GetBag(int32 SlotIndex) const
+{
+	if (!m_InventoryItems.IsValidIndex(SlotIndex) || !m_InventoryItems[SlotIndex].HasInstanceData())
+	{
+		return nullptr;
+	}
+
+	const int32 InstanceID = m_InventoryItems[SlotIndex].InstanceID;
+
+	if (GetOwnerRole() == ROLE_Authority)
+	{
+		return m_Bags.FindRef(InstanceID);
+	}
+
+	// Clients only know the bags that have replicated
+	TInlineComponentArray<UInventoryBagComponent*> Bags(GetOwner());
+
+	for (UInventoryBagComponent* const Bag : Bags)
+	{
+		if (Bag->GetParentInventory() == this && Bag->GetBagInstanceID() == InstanceID)
+		{
+			return Bag;
+		}
+	}
+
+	return nullptr;
+}
+
+void UInventoryComponent::AddBagContents(FName Key, int32 Delta, float WeightDelta)
+{
+	int32& Total = m_BagTotals.FindOrAdd(Key);
+	Total += Delta;
+
+	if (Total <= 0)
+	{
+		m_BagTotals.Remove(Key);
+	}
+
+	m_BagWeight += WeightDelta;
+
+	if (m_ChangeBatchDepth == 0)
+	{
+		UpdateEncumbrance();
+	}
+}
+
+UInventoryBagComponent* UInventoryComponent::CreateBag(int32 InstanceID, int32 Slots)
+{
+	UInventoryBagComponent* const Bag = NewObject<UInventoryBagComponent>(GetOwner());
+	Bag->InitializeBag(this, InstanceID, Slots);
+	Bag->RegisterComponent();
+
+	m_Bags.Add(InstanceID, Bag);
+
+	return Bag;
+}
+
+void UInventoryComponent::DestroyBag(int32 InstanceID)
+{
+	UInventoryBagComponent* Bag = nullptr;
+	if (!m_Bags.RemoveAndCopyValue(InstanceID, Bag) || Bag == nullptr)
+	{
+		return;
+	}
+
+	for (const TPair<FName, int32>& Total : Bag->GetContentTotals())
+	{
+		AddBagContents(Total.Key, -Total.Value, 0.0f);
+	}
+
+	m_BagWeight -= Bag->GetContentWeight();
+
+	if (m_ChangeBatchDepth == 0)
+	{
+		UpdateEncumbrance();
+	}
+
+	Bag->DestroyComponent();
+}
+
+bool UInventoryComponent::SpillBag(int32 InstanceID)
+{
+	UInventoryBagComponent* const Bag = m_Bags.FindRef(InstanceID);
+	if (Bag == nullptr)
+	{
+		return true;
+	}
+
+	if (Bag->GetContentTotals().Num() > 0)
+	{
+		// Moved out a slot at a time so whatever can't go anywhere stays in the bag
+		Bag->EnsureMaterialized();
+
+		UInventoryComponent* const BagInventory = Bag;
+
+		FInventoryChangeBatch Batch(this);
+		FInventoryChangeBatch BagBatch(BagInventory);
+
+		for (int32 i = 0; i < BagInventory->m_InventoryItems.Num(); i++)
+		{
+			const FInventoryItemStack Stack = BagInventory->m_InventoryItems[i];
+			if (Stack.IsEmptySlot())
+			{
+				continue;
+			}
+
+			// Out of the bag first so the totals and weight only count it once, its instance data stays in the bag until the bag prunes it
+			BagInventory->SetSlot(i, FInventoryItemStack());
+
+			const int32 Added = InsertStack(Stack);
+
+			const FInventoryInstanceData* const Data = Stack.HasInstanceData() ? Bag->FindInstanceData(Stack.InstanceID) : nullptr;
+			if (Added > 0 && Data)
+			{
+				FInventoryInstanceData& NewData = m_InstanceData.FindOrAdd(Stack.InstanceID);
+				NewData.Properties = Data->Properties;
+				NewData.Tags = Data->Tags;
+				m_InstanceData.MarkItemDirty(NewData);
+			}
+
+			if (Added >= Stack.StackSize)
+			{
+				continue;
+			}
+
+			FInventoryItemStack Leftover = Stack;
+			Leftover.StackSize -= Added;
+
+			if (!SpawnOrQueueDrop(Leftover))
+			{
+				BagInventory->SetSlot(i, Leftover);
+			}
+		}
+	}
+
+	if (Bag->GetContentTotals().Num() > 0)
+	{
+		LOG("A bag left the inventory and not everything in it could be put back or dropped, keeping the bag");
+		return false;
+	}
+
+	DestroyBag(InstanceID);
+	return true;
+}
+
+bool UInventoryComponent::HasBagContents(int32 SlotIndex) const
+{
+	const UInventoryBagComponent* const Bag = GetBag(SlotIndex);
+	return Bag && Bag->GetContentTotals().Num() > 0;
+}
+
+bool UInventoryComponent::CanCraft(const UInventoryRecipe* Recipe) const
+{
+	const int32 RecipeIndex = m_CraftingSubsystem ? m_CraftingSubsystem->GetRecipeIndex(Recipe) : INDEX_NONE;
+	return RecipeIndex != INDEX_NONE && m_CraftableRecipes.IsValidIndex(RecipeIndex) && m_CraftableRecipes[RecipeIndex];
+}
+
+TArray<UInventoryRecipe*> UInventoryComponent::GetCraftableRecipes() const
+{
+	TArray<UInventoryRecipe*> Recipes;
+
+	for (TConstSetBitIterator<> It(m_CraftableRecipes); It; ++It)
+	{
+		Recipes.Add(m_CraftingSubsystem->GetRecipe(It.GetIndex()));
+	}
+
+	return Recipes;
+}
+
+void UInventoryComponent::CraftRecipe(UInventoryRecipe* Recipe, int32 Count)
+{
+	const int32 RecipeIndex = m_CraftingSubsystem ? m_CraftingSubsystem->GetRecipeIndex(Recipe) : INDEX_NONE;
+	if (RecipeIndex == INDEX_NONE || Count <= 0 || Count > MaxCraftCount)
+	{
+		return;
+	}
+
+	// No point asking the server
+	if (GetOwnerRole() < ROLE_Authority && !CanCraft(Recipe))
+	{
+		return;
+	}
+
+	QueueOperation(FInventoryOperation(EInventoryOperation::Craft, RecipeIndex, INDEX_NONE, Count));
+}
+
+bool UInventoryComponent::Server_CraftRecipe_Validate(int32 RecipeIndex, int32 Count, int32 Sequence) { return RecipeIndex >= 0 && Count > 0 && Count <= MaxCraftCount && Sequence >= 0; }
+void UInventoryComponent::Server_CraftRecipe_Implementation(int32 RecipeIndex, int32 Count, int32 Sequence)
+{
+	ReceiveOperation(FInventoryOperation(EInventoryOperation::Craft, RecipeIndex, INDEX_NONE, Count), Sequence);
+}
+
+bool UInventoryComponent::ApplyCraft(int32 RecipeIndex, int32 Count)
+{
+	UInventoryRecipe* const Recipe = m_CraftingSubsystem ? m_CraftingSubsystem->GetRecipe(RecipeIndex) : nullptr;
+	if (Recipe == nullptr || Count <= 0 || Count > MaxCraftCount || !Recipe->HasInputs(m_ItemTotals, Count))
+	{
+		return false;
+	}
+
+	FInventoryChangeBatch Batch(this);
+
+	// Kept so everything can be put back if the outputs don't fit
+	const TArray<FInventoryItemStack> Snapshot = m_InventoryItems;
+
+	bool bSucceeded = true;
+
+	for (const FInventoryItemMeta& Input : Recipe->m_Inputs)
+	{
+		// HasInputs already checked the quantity fits in the totals
+		const int32 Quantity = (int32)((int64)Input.Quantity * Count);
+
+		// Bags that aren't empty count towards the totals but can't be consumed
+		if (ConsumeItem(Input.ItemRowName, Quantity) < Quantity)
+		{
+			bSucceeded = false;
+			break;
+		}
+	}
+
+	for (int32 i = 0; i < Recipe->m_Outputs.Num() && bSucceeded; i++)
+	{
+		const FInventoryItemMeta& Output = Recipe->m_Outputs[i];
+
+		const FInventoryItem* const Item = FindItemData(Output.ItemRowName);
+		const int64 Quantity = (int64)Output.Quantity * Count;
+
+		if (Item == nullptr || Quantity <= 0 || Quantity > MAX_int32 || InsertStack(FInventoryItemStack(*Item, (int32)Quantity)) < Quantity)
+		{
+			bSucceeded = false;
+			break;
+		}
+	}
+
+	if (!bSucceeded)
+	{
+		for (int32 i = 0; i < Snapshot.Num(); i++)
+		{
+			if (m_InventoryItems[i].Version != Snapshot[i].Version)
+			{
+				SetSlot(i, Snapshot[i]);
+			}
+		}
+
+		return false;
+	}
+
+	OnItemCrafted.Broadcast(GetOwner(), Recipe, Count);
+	return true;
+}
+
+int32 UInventoryComponent::ConsumeItem(const FName& ItemID, int32 Quantity)
+{
+	int32 Consumed = 0;
+
+	const int32 SlotsCount = FMath::Min(GetInventorySlotsCount(), m_InventoryItems.Num());
+
+	// The inventory from the back so the first slots are emptied last, then the action bar
+	for (int32 n = 0; n < m_InventoryItems.Num() && Consumed < Quantity; n++)
+	{
+		const int32 i = n < SlotsCount ? SlotsCount - 1 - n : m_InventoryItems.Num() - 1 - (n - SlotsCount);
+
+		// A bag has to be emptied before it can be used up
+		if (m_InventoryItems[i].IsEmptySlot() || m_InventoryItems[i].InventoryItem.GetKey() != ItemID || HasBagContents(i))
+		{
+			continue;
+		}
+
+		FInventoryItemStack Stack = m_InventoryItems[i];
+		const int32 CountToTake = FMath::Min(Quantity - Consumed, Stack.StackSize);
+
+		Stack.StackSize -= CountToTake;
+		SetSlot(i, Stack.StackSize > 0 ? Stack : FInventoryItemStack());
+
+		Consumed += CountToTake;
+	}
+
+	return Consumed;
+}
+
+void UInventoryComponent::BeginChangeBatch()
+{
+	m_ChangeBatchDepth++;
+}
+
+void UInventoryComponent::EndChangeBatch()
+{
+	check(m_ChangeBatchDepth > 0);
+
+	if (--m_ChangeBatchDepth > 0)
+	{
+		return;
+	}
+
+	UpdateCraftableRecipes();
+	UpdateEncumbrance();
+
+	if (m_bChangedInBatch)
+	{
+		m_bChangedInBatch = false;
+		OnInventoryChanged.Broadcast();
+	}
+}
+
+bool UInventoryComponent::GetUseTrace(FVector& OutStart, FVector& OutEnd, FCollisionQueryParams& OutParams) const
+{
+	ACharacter* const Character = Cast<ACharacter>(GetOwner());
+
+	if (Character == nullptr || Character->GetController() == nullptr)
+	{
+		PRINT("Character or Controller are nullptr");
+		return false;
+	}
+
+	FRotator CameraRotation;
+	Character->GetController()->GetPlayerViewPoint(OutStart, CameraRotation);
+
+	OutEnd = OutStart + (CameraRotation.Vector() * m_MaxUseDistance);
+
+	OutParams = FCollisionQueryParams(FName(TEXT("")), true, GetOwner());
+	OutParams.bTraceComplex = true;
+
+	return true;
+}
+
+class AInventoryBaseItem* UInventoryComponent::GetActorInView()
+{
+	FVector CameraLocation;
+	FVector EndLocation;
+	FCollisionQueryParams TraceParams;
+
+	if (!GetUseTrace(CameraLocation, EndLocation, TraceParams))
+	{
+		return nullptr;
+	}
+
+	FHitResult HitRes;
+	GetWorld()->LineTraceSingleByChannel(HitRes, CameraLocation, EndLocation, ECC_GameTraceChannel18, TraceParams);
+
+#ifdef _DEBUG
+	DrawDebugLine(GetWorld(), CameraLocation, EndLocation, FColor::Yellow, false, 10.0f, 0, 1.0f);
+	DrawDebugSphere(GetWorld(), HitRes.Location, 3.0f, 5, FColor::Orange);
+#endif
+
+	return Cast<AInventoryBaseItem>(HitRes.Actor);
+}
+
+void UInventoryComponent::PickupItem()
+{
+	Server_PickupItem();
+}
+
+bool UInventoryComponent::Server_PickupItem_Validate() { return true; }
+void UInventoryComponent::Server_PickupItem_Implementation()
+{
+	UInventorySubsystem* const Subsystem = GetWorld()->GetSubsystem<UInventorySubsystem>();
+	if (Subsystem && !Subsystem->ConsumeOperationBudget(GetOwner()->GetNetConnection()))
+	{
+		return;
+	}
+
+	if (IsInventoryFull())
+	{
+		PRINT("Your inventory is full!");
+		return;
+	}
+
+	// Only one trace in flight, anything more is the interact key being spammed
+	if (m_bPickupTracePending)
+	{
+		return;
+	}
+
+	FVector Start;
+	FVector End;
+	FCollisionQueryParams TraceParams;
+
+	if (!GetUseTrace(Start, End, TraceParams))
+	{
+		return;
+	}
+
+	// Every trace requested this frame runs together off the game thread and the results come back next frame
+	m_bPickupTracePending = true;
+	m_PickupTrace = GetWorld()->AsyncLineTraceByChannel(EAsyncTraceType::Single, Start, End, ECC_GameTraceChannel18, TraceParams);
+
+	// The timer manager drops the call if the component is gone by then
+	GetWorld()->GetTimerManager().SetTimerForNextTick(this, &UInventoryComponent::CheckPickupTrace);
+}
+
+void UInventoryComponent::CheckPickupTrace()
+{
+	if (!m_bPickupTracePending)
+	{
+		return;
+	}
+
+	FTraceDatum Datum;
+	if (!GetWorld()->QueryTraceData(m_PickupTrace, Datum))
+	{
+		// Not in yet, the handle is only valid for a couple of frames
+		if (GetWorld()->IsTraceHandleValid(m_PickupTrace, false))
+		{
+			GetWorld()->GetTimerManager().SetTimerForNextTick(this, &UInventoryComponent::CheckPickupTrace);
+		}
+		else
+		{
+			m_bPickupTracePending = false;
+		}
+
+		return;
+	}
+
+	m_bPickupTracePending = false;
+
+	// Another pickup may have taken the item since the trace was requested, the weak pointer is cleared once it's destroyed
+	AInventoryBaseItem* const Item = Datum.OutHits.Num() > 0 ? Cast<AInventoryBaseItem>(Datum.OutHits[0].Actor.Get()) : nullptr;
+
+	if (Item)
+	{
+		PickupActor(Item);
+	}
+}
+
+void UInventoryComponent::PickupActor(AInventoryBaseItem* Item)
+{
+	FInventoryItemMeta& Meta = Item->GetInventoryItemMeta();
+
+	const FInventoryItem* const ItemData = FindItemData(Meta.ItemRowName);
+	if (ItemData == nullptr || Meta.Quantity <= 0)
+	{
+		return;
+	}
+
+	FInventoryItemStack ItemStack(*ItemData, Meta.Quantity);
+
+	// Only what fits is taken, the weight limit or the grid can leave some of the stack behind
+	const int32 Added = AddItem(ItemStack);
+	if (Added <= 0)
+	{
+		return;
+	}
+
+	if (Added < Meta.Quantity)
+	{
+		Meta.Quantity -= Added;
+
+		ItemStack.StackSize = Added;
+		OnItemPickedUp.Broadcast(GetOwner(), ItemStack);
+		return;
+	}
+
+	OnItemPickedUp.Broadcast(GetOwner(), ItemStack);
+
+	Item->Destroy();
+}
+
+void UInventoryComponent::DropItem(int32 ItemIndex, int32 Quantity)
+{
+	QueueOperation(FInventoryOperation(EInventoryOperation::Drop, ItemIndex, INDEX_NONE, Quantity));
+}
+
+bool UInventoryComponent::Server_DropItem_Validate(int32 ItemIndex, int32 Quantity, int32 Sequence) { return IsValidSlotIndex(ItemIndex) && Quantity >= 0 && Sequence >= 0; }
+void UInventoryComponent::Server_DropItem_Implementation(int32 ItemIndex, int32 Quantity, int32 Sequence)
+{
+	ReceiveOperation(FInventoryOperation(EInventoryOperation::Drop, ItemIndex, INDEX_NONE, Quantity), Sequence);
+}
+
+bool UInventoryComponent::ApplyDrop(int32 ItemIndex, int32 Quantity)
+{
+	if (!m_InventoryItems.IsValidIndex(ItemIndex) || m_InventoryItems[ItemIndex].IsEmptySlot())
+	{
+		return false;
+	}
+
+	// The world item can't carry what's in the bag
+	if (HasBagContents(ItemIndex))
+	{
+		LOG("The bag has to be emptied before it can be dropped");
+		return false;
+	}
+
+	const FInventoryItemStack Item = m_InventoryItems[ItemIndex];
+	const TSoftClassPtr<AInventoryBaseItem>& ObjectClass = Item.InventoryItem.ObjectClass;
+
+	if (ObjectClass.IsNull())
+	{
+		LOG("The item doesn't have a world item class to drop");
+		return false;
+	}
+
+	if (SpawnOrQueueDrop(Item))
+	{
+		RemoveItemBySlot(ItemIndex);
+		//RemoveItem(Item);
+
+		return true;
+	}
+
+	return false;
+}
+
+bool UInventoryComponent::SpawnOrQueueDrop(const FInventoryItemStack& Item)
+{
+	const TSoftClassPtr<AInventoryBaseItem>& ObjectClass = Item.InventoryItem.ObjectClass;
+	const ACharacter* const Character = Cast<ACharacter>(GetOwner());
+
+	// Only a controlled character has somewhere to drop it, checked now so a queued drop can't fail later
+	if (ObjectClass.IsNull() || Character == nullptr || Character->GetController() == nullptr)
+	{
+		return false;
+	}
+
+	if (ObjectClass.Get() == nullptr)
+	{
+		// The class is still streaming in, take the item now and spawn it once the class has loaded instead of loading it synchronously
+		const FSoftObjectPath ClassPath = ObjectClass.ToSoftObjectPath();
+		const bool bAlreadyWaiting = m_PendingDrops.Contains(ClassPath);
+
+		m_PendingDrops.FindOrAdd(ClassPath).Add(Item);
+
+		if (!bAlreadyWaiting)
+		{
+			UAssetManager::GetStreamableManager().RequestAsyncLoad(ClassPath, FStreamableDelegate::CreateUObject(this, &UInventoryComponent::OnDropClassLoaded, ClassPath), FStreamableManager::AsyncLoadHighPriority);
+		}
+
+		return true;
+	}
+
+	return SpawnDroppedItem(Item) != nullptr;
+}
+
+void UInventoryComponent::ReleaseHeldClass(const FSoftObjectPath& ClassPath)
+{
+	// Still held by a slot or waited on by a drop
+	if (m_HeldClassCounts.Contains(ClassPath) || m_PendingDrops.Contains(ClassPath))
+	{
+		return;
+	}
+
+	TSharedPtr<FStreamableHandle> Handle;
+	if (m_ClassHandles.RemoveAndCopyValue(ClassPath, Handle) && Handle.IsValid())
+	{
+		Handle->ReleaseHandle();
+	}
+}
+
+void UInventoryComponent::UpdateHeldClass(const FInventoryItemStack& Stack, int32 Delta)
+{
+	if (Stack.IsEmptySlot() || Stack.InventoryItem.ObjectClass.IsNull())
+	{
+		return;
+	}
+
+	const FSoftObjectPath ClassPath = Stack.InventoryItem.ObjectClass.ToSoftObjectPath();
+	int32& Count = m_HeldClassCounts.FindOrAdd(ClassPath);
+	Count += Delta;
+
+	if (Count <= 0)
+	{
+		// Nothing holds this item anymore so let the class unload
+		m_HeldClassCounts.Remove(ClassPath);
+		ReleaseHeldClass(ClassPath);
+	}
+	else if (!m_ClassHandles.Contains(ClassPath))
+	{
+		m_ClassHandles.Add(ClassPath, UAssetManager::GetStreamableManager().RequestAsyncLoad(ClassPath, FStreamableDelegate(), FStreamableManager::AsyncLoadHighPriority));
+	}
+}
+
+AInventoryBaseItem* UInventoryComponent::SpawnDroppedItem(const FInventoryItemStack& Item)
+{
+	ACharacter* const Character = Cast<ACharacter>(GetOwner());
+
+	if (Character == nullptr || Character->GetController() == nullptr)
+	{
+		LOG("Character is null or Controller is null");
+		return nullptr;
+	}
+
+	UClass* const ObjectClass = Item.InventoryItem.ObjectClass.Get();
+	if (ObjectClass == nullptr)
+	{
+		LOG("The world item class isn't loaded");
+		return nullptr;
+	}
+
+	FVector CameraLocation;
+	FRotator CameraRotation;
+	Character->GetController()->GetPlayerViewPoint(CameraLocation, CameraRotation);
+
+	FVector EndLocation = CameraLocation + (CameraRotation.Vector() * 150.0f);
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+	SpawnParams.Owner = GetOwner();
+	SpawnParams.Instigator = Character;
+
+	AInventoryBaseItem* const SpawnedActor = GetWorld()->SpawnActor<AInventoryBaseItem>(ObjectClass, UKismetMathLibrary::MakeTransform(EndLocation, {}, { 1.0f, 1.0f, 1.0f }), SpawnParams);
+	if (SpawnedActor)
+	{
+		// NOTE: required to enable physics on the mesh in the actor (if any) so the actor doesn't just hover in the level
+
+		FInventoryItemMeta& NewMeta = SpawnedActor->GetInventoryItemMeta();
+		NewMeta.Quantity = Item.StackSize;
+		SpawnedActor->SetInventoryItemMeta(NewMeta);
+
+		OnItemDropped.Broadcast(GetOwner(), Item);
+	}
+
+	return SpawnedActor;
+}
+
+void UInventoryComponent::OnDropClassLoaded(FSoftObjectPath ClassPath)
+{
+	TArray<FInventoryItemStack> Drops;
+	if (!m_PendingDrops.RemoveAndCopyValue(ClassPath, Drops))
+	{
+		return;
+	}
+
+	for (const FInventoryItemStack& Item : Drops)
+	{
+		// Couldn't spawn it so give it back rather than losing it
+		if (SpawnDroppedItem(Item) == nullptr)
+		{
+			const int32 Added = AddItem(Item);
+			if (Added < Item.StackSize)
+			{
+				LOG("Couldn't drop or give back %d of %s", Item.StackSize - Added, *Item.InventoryItem.ID.ToString());
+			}
+		}
+	}
+
+	// Release the class if the drops were the last thing holding it
+	ReleaseHeldClass(ClassPath);
+}
+
+int32 UInventoryComponent::AddItem(const FInventoryItemStack& ItemToAdd)
+{
+	if (GetCapacityFor(ItemToAdd) <= 0)
+	{
+		PRINT("Your inventory is full!");
+		return 0;
+	}
+
+	return InsertStack(ItemToAdd);
+}
+
+int32 UInventoryComponent::AddItems(const TArray<FInventoryItemMeta>& Items)
+{
+	// Merge duplicates first so each item is only looked up and inserted once
+	TMap<FName, int32, TInlineSetAllocator<16>> Quantities;
+	for (const FInventoryItemMeta& Meta : Items)
+	{
+		if (Meta.Quantity > 0)
+		{
+			Quantities.FindOrAdd(Meta.ItemRowName) += Meta.Quantity;
+		}
+	}
+
+	FInventoryChangeBatch Batch(this);
+
+	int32 Added = 0;
+
+	for (const TPair<FName, int32>& Pair : Quantities)
+	{
+		if (const FInventoryItem* const Item = FindItemData(Pair.Key))
+		{
+			Added += InsertStack(FInventoryItemStack(*Item, Pair.Value));
+		}
+		else
+		{
+			LOG("%s isn't in the item DataTable", *Pair.Key.ToString());
+		}
+	}
+
+	return Added;
+}
+
+int32 UInventoryComponent::GetCapacityFor(const FInventoryItemStack& Stack) const
+{
+	if (Stack.IsEmptySlot() || (Stack.InventoryItem.IsBag() && !CanHoldBags()))
+	{
+		return 0;
+	}
+
+	PrepareSlots();
+
+	const FInventoryItem& Item = Stack.InventoryItem;
+	const int32 MaxStackSize = FMath::Max(1, Item.MaxStackSize);
+	int32 Capacity = 0;
+
+	// Room left on the partial stacks of this item, no need to look at any other slot
+	if (Item.bAutoStack && Item.CanStack() && !Stack.HasInstanceData())
+	{
+		if (const TArray<int32>* Slots = m_PartialStacks.Find(Item.GetKey()))
+		{
+			for (int32 Index : *Slots)
+			{
+				Capacity += m_InventoryItems[Index].GetEmptySizeLeft();
+			}
+		}
+	}
+
+	if (!m_bUseFootprints)
+	{
+		return GetCountWithinWeight(Item, Capacity + m_EmptySlotCount * MaxStackSize);
+	}
+
+	// Empty slots in the grid don't mean the item fits, place new stacks on a copy of the grid until it's full
+	for (int32 i = GetInventorySlotsCount(); i < m_InventoryItems.Num(); i++)
+	{
+		Capacity += m_InventoryItems[i].IsEmptySlot() ? MaxStackSize : 0;
+	}
+
+	const FIntPoint Size = Stack.GetFootprint();
+	const bool bCanRotate = Item.bCanRotate && Size.X != Size.Y;
+
+	FInventoryGrid Grid = m_Grid;
+	int32 Row = 0;
+	int32 Column = 0;
+
+	while (Capacity < Stack.StackSize)
+	{
+		if (Grid.FindFirstFit(Size.X, Size.Y, Row, Column))
+		{
+			Grid.Set(Row, Column, Size.X, Size.Y, true);
+		}
+		else if (bCanRotate && Grid.FindFirstFit(Size.Y, Size.X, Row, Column))
+		{
+			Grid.Set(Row, Column, Size.Y, Size.X, true);
+		}
+		else
+		{
+			break;
+		}
+
+		Capacity += MaxStackSize;
+	}
+
+	return GetCountWithinWeight(Item, Capacity);
+}
+
+int32 UInventoryComponent::InsertStack(const FInventoryItemStack& Stack)
+{
+	if (Stack.IsEmptySlot() || (Stack.InventoryItem.IsBag() && !CanHoldBags()))
+	{
+		return 0;
+	}
+
+	PrepareSlots();
+
+	FInventoryChangeBatch Batch(this);
+
+	const FInventoryItem& Item = Stack.InventoryItem;
+
+	// Only as many as the weight limit allows, the rest is left for the caller
+	const int32 Inserting = GetCountWithinWeight(Item, Stack.StackSize);
+	int32 Remaining = Inserting;
+
+	// Check if the item can be auto stacked and if it can stack at all
+	if (Item.bAutoStack && Item.CanStack() && !Stack.HasInstanceData())
+	{
+		if (const TArray<int32>* Slots = m_PartialStacks.Find(Item.GetKey()))
+		{
+			// Copy since filling a stack takes it out of the index
+			const TArray<int32, TInlineAllocator<8>> PartialSlots(*Slots);
+
+			for (int32 Index : PartialSlots)
+			{
+				FInventoryItemStack Partial = m_InventoryItems[Index];
+
+				// Get the amount to add based on how many the stack allows
+				const int32 CountToAdd = FMath::Min(Remaining, Partial.GetEmptySizeLeft());
+
+				Partial.MergeCondition(Stack, CountToAdd, GetInventoryTime());
+				Partial.StackSize += CountToAdd;
+				SetSlot(Index, Partial);
+
+				// Remove the count of this item so we can create another stack if necessary
+				Remaining -= CountToAdd;
+
+				if (Remaining <= 0)
+				{
+					break;
+				}
+			}
+		}
+	}
+
+	// Put the rest into empty slots, splitting it into as many stacks as the max stack size needs
+	while (Remaining > 0 && m_EmptySlotCount > 0)
+	{
+		FInventoryItemStack NewStack = Stack;
+		NewStack.StackSize = FMath::Min(Remaining, FMath::Max(1, Item.MaxStackSize));
+
+		const int32 Slot = FindSlotFor(NewStack);
+		if (Slot == INDEX_NONE)
+		{
+			break;
+		}
+
+		SetSlot(Slot, NewStack);
+		Remaining -= NewStack.StackSize;
+	}
+
+	return Inserting - Remaining;
+}
+
+bool UInventoryComponent::TransferItem(UInventoryComponent* Target, int32 SlotIndex, int32 Quantity)
+{
+	PrepareSlots();
+
+	if (GetOwnerRole() != ROLE_Authority || Target == nullptr || Target == this || !m_InventoryItems.IsValidIndex(SlotIndex) || m_InventoryItems[SlotIndex].IsEmptySlot())
+	{
+		return false;
+	}
+
+	FInventoryItemStack Source = m_InventoryItems[SlotIndex];
+
+	// Stacks with instance data move whole
+	const int32 CountToMove = Quantity > 0 && !Source.HasInstanceData() ? FMath::Min(Quantity, Source.StackSize) : Source.StackSize;
+
+	FInventoryItemStack Moving = Source;
+	Moving.StackSize = CountToMove;
+
+	// Check first so nothing is left half moved
+	if (Target->GetCapacityFor(Moving) < CountToMove)
+	{
+		return false;
+	}
+
+	// A bag's contents move with it, which needs them in the compact form
+	UInventoryBagComponent* const Bag = Moving.InventoryItem.IsBag() ? GetBag(SlotIndex) : nullptr;
+	TArray<FInventoryItemMeta> BagContents;
+
+	if (Bag && !Bag->ExportContents(BagContents))
+	{
+		return false;
+	}
+
+	// What's in the bag counts towards the target's weight limit too
+	if (Bag && Bag->GetContentWeight() > 0.0f && Target->GetWeightLeft() + KINDA_SMALL_NUMBER < Moving.GetWeight() + Bag->GetContentWeight())
+	{
+		return false;
+	}
+
+	FInventoryChangeBatch SourceBatch(this);
+	FInventoryChangeBatch TargetBatch(Target);
+
+	// The instance data goes with the stack, the ID is unique across the world so it can be kept
+	if (const FInventoryInstanceData* const InstanceData = m_InstanceData.Find(Moving.InstanceID))
+	{
+		FInventoryInstanceData& TargetData = Target->m_InstanceData.FindOrAdd(Moving.InstanceID);
+		TargetData.Properties = InstanceData->Properties;
+		TargetData.Tags = InstanceData->Tags;
+		Target->m_InstanceData.MarkItemDirty(TargetData);
+	}
+
+	Target->InsertStack(Moving);
+
+	Source.StackSize -= CountToMove;
+	SetSlot(SlotIndex, Source.StackSize > 0 ? Source : FInventoryItemStack());
+
+	if (Bag)
+	{
+		DestroyBag(Moving.InstanceID);
+
+		if (BagContents.Num() > 0)
+		{
+			Target->CreateBag(Moving.InstanceID, Moving.InventoryItem.BagSlots)->AdoptContents(BagContents);
+		}
+	}
+
+	return true;
+}
+
+int32 UInventoryComponent::ApplySlotChanges(const TArray<TPair<int32, FInventoryItemStack>>& Changes)
+{
+	if (GetOwnerRole() != ROLE_Authority)
+	{
+		return 0;
+	}
+
+	FInventoryChangeBatch Batch(this);
+
+	int32 SlotsWritten = 0;
+
+	// Empty the cleared slots first so their footprints aren't in the way of the stacks that changed size
+	for (const TPair<int32, FInventoryItemStack>& Change : Changes)
+	{
+		if (m_InventoryItems.IsValidIndex(Change.Key) && Change.Value.StackSize <= 0)
+		{
+			SetSlot(Change.Key, FInventoryItemStack());
+			SlotsWritten++;
+		}
+	}
+
+	// ReplaceSlot moves or drops a stack whose new footprint no longer fits where it was
+	for (const TPair<int32, FInventoryItemStack>& Change : Changes)
+	{
+		if (m_InventoryItems.IsValidIndex(Change.Key) && Change.Value.StackSize > 0 && ReplaceSlot(Change.Key, Change.Value))
+		{
+			SlotsWritten++;
+		}
+	}
+
+	return SlotsWritten;
+}
+
+int32 UInventoryComponent::TransferAll(UInventoryComponent* Target)
+{
+	return TransferByFilter(Target, [](const FInventoryItemStack&) { return true; });
+}
+
+int32 UInventoryComponent::TransferByFilter(UInventoryComponent* Target, FInventoryItemFilter Filter)
+{
+	return TransferByFilter(Target, [&Filter](const FInventoryItemStack& Item) { return Filter.IsBound() && Filter.Execute(Item); });
+}
+
+int32 UInventoryComponent::TransferByFilter(UInventoryComponent* Target, TFunctionRef<bool(const FInventoryItemStack&)> Filter)
+{
+	if (GetOwnerRole() != ROLE_Authority || Target == nullptr || Target == this)
+	{
+		return 0;
+	}
+
+	PrepareSlots();
+
+	// One change event for each inventory no matter how many slots move
+	FInventoryChangeBatch SourceBatch(this);
+	FInventoryChangeBatch TargetBatch(Target);
+
+	int32 SlotsMoved = 0;
+
+	for (int32 i = 0; i < m_InventoryItems.Num(); i++)
+	{
+		if (!m_InventoryItems[i].IsEmptySlot() && Filter(m_InventoryItems[i]) && TransferItem(Target, i))
+		{
+			SlotsMoved++;
+		}
+	}
+
+	return SlotsMoved;
+}
+
+int32 UInventoryComponent::RemoveItem(const FInventoryItemStack& ItemToRemove)
+{
+	FInventoryChangeBatch Batch(this);
+
+	int32 ItemStackSize = ItemToRemove.StackSize;
+
+	for (int32 i = 0; i < m_InventoryItems.Num(); i++)
+	{
+		if (m_InventoryItems[i] == ItemToRemove && !HasBagContents(i))
+		{
+			FInventoryItemStack item = m_InventoryItems[i];
+
+			// TODO: This shouldn't drop all, but rather allow a quantity to be dropped
+			int32 ItemCountToRemove = FMath::Min<int32>(ItemStackSize, item.StackSize);
+
+			item.StackSize -= ItemCountToRemove;
+
+			ItemStackSize -= ItemCountToRemove;
+
+			if (item.StackSize <= 0)
+			{
+				SetSlot(i, FInventoryItemStack());
+				// PRINT("DROPPED BOI");
+			}
+			else
+			{
+				SetSlot(i, item);
+			}
+
+			if (ItemStackSize <= 0)
+			{
+				break;
+			}
+		}
+	}
+
+	return ItemToRemove.StackSize - ItemStackSize;
+}
+
+FInventoryItemStack UInventoryComponent::RemoveItemBySlot(int32 SlotID)
+{
+	if (m_InventoryItems.IsValidIndex(SlotID))
+	{
+		if (HasBagContents(SlotID))
+		{
+			LOG("The bag has to be emptied before it can be removed");
+			return FInventoryItemStack();
+		}
+
+		FInventoryItemStack TmpItem = m_InventoryItems[SlotID];
+
+		SetSlot(SlotID, FInventoryItemStack());
+
+		return TmpItem;
+	}
+
+	return FInventoryItemStack();
+}
+
+void UInventoryComponent::ExecItem(int32 SlotIndex)
+{
+	// No point asking the server
+	if (!IsItemReady(SlotIndex))
+	{
+		return;
+	}
+
+	FInventoryOperation Operation(EInventoryOperation::Exec, SlotIndex);
+	Operation.SlotVersion = GetExpectedSlotVersion(SlotIndex);
+
+	QueueOperation(Operation);
+}
+
+bool UInventoryComponent::Server_ExecItem_Validate(int32 SlotIndex, int32 SlotVersion, int32 Sequence) { return IsValidSlotIndex(SlotIndex) && Sequence >= 0; }
+void UInventoryComponent::Server_ExecItem_Implementation(int32 SlotIndex, int32 SlotVersion, int32 Sequence)
+{
+	FInventoryOperation Operation(EInventoryOperation::Exec, SlotIndex);
+	Operation.SlotVersion = SlotVersion;
+
+	ReceiveOperation(Operation, Sequence);
+}
+
+bool UInventoryComponent::ApplyExec(int32 SlotIndex, int32 SlotVersion)
+{
+	if (!IsExpectedSlot(SlotIndex, SlotVersion) || m_InventoryItems[SlotIndex].IsEmptySlot())
+	{
+		return false;
+	}
+
+	const float Now = GetInventoryTime();
+
+	// The timer may not have fired yet
+	if (m_InventoryItems[SlotIndex].GetCondition(Now) <= 0.0f)
+	{
+		ExpireSlot(SlotIndex);
+		return false;
+	}
+
+	if (!IsItemReady(SlotIndex))
+	{
+		return false;
+	}
+
+	if (m_InventoryItems[SlotIndex].InventoryItem.CastTime > 0.0f)
+	{
+		StartCast(SlotIndex, Now);
+	}
+	else
+	{
+		CompleteExec(SlotIndex, Now);
+	}
+
+	return true;
+}
+
+void UInventoryComponent::CompleteExec(int32 SlotIndex, float Now)
+{
+	if (!m_InventoryItems.IsValidIndex(SlotIndex) || m_InventoryItems[SlotIndex].IsEmptySlot())
+	{
+		return;
+	}
+
+	const FInventoryItemStack Item = m_InventoryItems[SlotIndex];
+	StartCooldown(Item.InventoryItem, Now);
+
+	OnItemExec.Broadcast(GetOwner(), Item, Item.InventoryItem.ItemAction);
+
+	// Wear the item, the listeners may have changed the slot so only if it's still the same
+	if (Item.InventoryItem.ConditionLossPerUse > 0.0f && m_InventoryItems[SlotIndex].Version == Item.Version)
+	{
+		FInventoryItemStack Worn = Item;
+		Worn.SettleCondition(Now);
+		Worn.Condition -= Item.InventoryItem.ConditionLossPerUse;
+
+		if (Worn.Condition <= 0.0f)
+		{
+			ExpireSlot(SlotIndex);
+		}
+		else
+		{
+			SetSlot(SlotIndex, Worn);
+		}
+	}
+}
+
+void UInventoryComponent::StartCast(int32 SlotIndex, float Now)
+{
+	const FInventoryItemStack& Item = m_InventoryItems[SlotIndex];
+
+	m_ActiveCast.SlotIndex = SlotIndex;
+	m_ActiveCast.StartTime = Now;
+	m_ActiveCast.EndTime = Now + Item.InventoryItem.CastTime;
+	m_ActiveCast.Serial = ++m_LastCastSerial;
+
+	if (UInventorySubsystem* const Subsystem = GetWorld()->GetSubsystem<UInventorySubsystem>())
+	{
+		Subsystem->ScheduleTimer(this, EInventoryTimer::Cast, SlotIndex, m_ActiveCast.Serial, m_ActiveCast.EndTime);
+	}
+
+	OnCastStarted.Broadcast(GetOwner(), Item);
+}
+
+void UInventoryComponent::InterruptCast()
+{
+	if (!IsCasting())
+	{
+		return;
+	}
+
+	const int32 SlotIndex = m_ActiveCast.SlotIndex;
+	m_ActiveCast = FInventoryCast();
+
+	if (m_InventoryItems.IsValidIndex(SlotIndex))
+	{
+		OnCastInterrupted.Broadcast(GetOwner(), m_InventoryItems[SlotIndex]);
+	}
+}
+
+void UInventoryComponent::CancelCast()
+{
+	if (GetOwnerRole() < ROLE_Authority)
+	{
+		Server_CancelCast();
+		return;
+	}
+
+	InterruptCast();
+}
+
+bool UInventoryComponent::Server_CancelCast_Validate() { return true; }
+void UInventoryComponent::Server_CancelCast_Implementation()
+{
+	InterruptCast();
+}
+
+void UInventoryComponent::StartCooldown(const FInventoryItem& Item, float Now)
+{
+	if (Item.Cooldown <= 0.0f)
+	{
+		return;
+	}
+
+	const FName Group = Item.GetCooldownGroup();
+	const float EndTime = Now + Item.Cooldown;
+
+	if (const int32* const Index = m_CooldownIndex.Find(Group))
+	{
+		m_Cooldowns[*Index].EndTime = FMath::Max(m_Cooldowns[*Index].EndTime, EndTime);
+	}
+	else
+	{
+		m_CooldownIndex.Add(Group, m_Cooldowns.Emplace(Group, EndTime));
+	}
+
+	if (UInventorySubsystem* const Subsystem = GetWorld()->GetSubsystem<UInventorySubsystem>())
+	{
+		Subsystem->ScheduleTimer(this, EInventoryTimer::Cooldown, INDEX_NONE, 0, EndTime);
+	}
+}
+
+void UInventoryComponent::PruneCooldowns(float Now)
+{
+	TArray<FName, TInlineAllocator<4>> Ended;
+
+	for (int32 i = m_Cooldowns.Num() - 1; i >= 0; i--)
+	{
+		if (m_Cooldowns[i].EndTime <= Now)
+		{
+			Ended.Add(m_Cooldowns[i].Group);
+			m_Cooldowns.RemoveAtSwap(i);
+		}
+	}
+
+	if (Ended.Num() > 0)
+	{
+		RebuildCooldownIndex();
+
+		for (const FName& Group : Ended)
+		{
+			OnCooldownEnded.Broadcast(Group);
+		}
+	}
+}
+
+void UInventoryComponent::RebuildCooldownIndex()
+{
+	m_CooldownIndex.Reset();
+
+	for (int32 i = 0; i < m_Cooldowns.Num(); i++)
+	{
+		m_CooldownIndex.Add(m_Cooldowns[i].Group, i);
+	}
+}
+
+void UInventoryComponent::OnRep_Cooldowns()
+{
+	RebuildCooldownIndex();
+}
+
+float UInventoryComponent::GetCooldownRemaining(FName CooldownGroup) const
+{
+	const int32* const Index = m_CooldownIndex.Find(CooldownGroup);
+	return Index ? FMath::Max(0.0f, m_Cooldowns[*Index].EndTime - GetInventoryTime()) : 0.0f;
+}
+
+bool UInventoryComponent::IsItemReady(int32 SlotIndex) const
+{
+	const FInventoryItemStack& Stack = GetDisplayedSlot(SlotIndex);
+	return !Stack.IsEmptySlot() && !IsCasting() && GetCooldownRemaining(Stack.InventoryItem.GetCooldownGroup()) <= 0.0f;
+}
+
+void UInventoryComponent::SwapItem(int32 CurrentIndex, int32 NewIndex)
+{
+	if (GetOwnerRole() < ROLE_Authority)
+	{
+		FInventoryItemStack Current = GetDisplayedSlot(CurrentIndex);
+		FInventoryItemStack New = GetDisplayedSlot(NewIndex);
+
+		if (!SwapStacks(Current, New))
+		{
+			return;
+		}
+
+		const int32 Sequence = QueueOperation(FInventoryOperation(EInventoryOperation::Swap, CurrentIndex, NewIndex));
+		PredictSlot(CurrentIndex, Current, Sequence);
+		PredictSlot(NewIndex, New, Sequence);
+		return;
+	}
+
+	QueueOperation(FInventoryOperation(EInventoryOperation::Swap, CurrentIndex, NewIndex));
+}
+
+bool UInventoryComponent::Server_SwapItem_Validate(int32 CurrentIndex, int32 NewIndex, int32 Sequence) { return IsValidSlotIndex(CurrentIndex) && IsValidSlotIndex(NewIndex) && Sequence >= 0; }
+void UInventoryComponent::Server_SwapItem_Implementation(int32 CurrentIndex, int32 NewIndex, int32 Sequence)
+{
+	// If the 2 items in each index are the same and can stack then stack them, else don't swap (unless the health of the item is different etc)
+
+	ReceiveOperation(FInventoryOperation(EInventoryOperation::Swap, CurrentIndex, NewIndex), Sequence);
+}
+
+bool UInventoryComponent::ApplySwap(int32 CurrentIndex, int32 NewIndex)
+{
+	if (!m_InventoryItems.IsValidIndex(CurrentIndex) || !m_InventoryItems.IsValidIndex(NewIndex))
+	{
+		return false;
+	}
+
+	FInventoryItemStack Current = m_InventoryItems[CurrentIndex];
+	FInventoryItemStack New = m_InventoryItems[NewIndex];
+
+	if (!SwapStacks(Current, New))
+	{
+		return false;
+	}
+
+	// Both stacks have to fit where they're going once they've left where they were
+	if (m_bUseFootprints)
+	{
+		TArray<TPair<int32, FInventoryItemStack>> Placements;
+		Placements.Emplace(CurrentIndex, Current);
+		Placements.Emplace(NewIndex, New);
+
+		if (!FitsInGrid(Placements, CurrentIndex, NewIndex))
+		{
+			return false;
+		}
+	}
+
+	SetSlot(CurrentIndex, Current);
+	SetSlot(NewIndex, New);
+	// m_InventoryItems[CurrentIndex] = FInventoryItemStack();
+
+	OnItemMoved.Broadcast(GetOwner(), m_InventoryItems[CurrentIndex], CurrentIndex, NewIndex);
+
+	return true;
+}
+
+bool UInventoryComponent::HasEmptySlot() const
+{
+	if (!m_bUseFootprints)
+	{
+		return m_EmptySlotCount > 0;
+	}
+
+	// Slots covered by a bigger item are empty in the array but not free
+	int32 Row = 0;
+	int32 Column = 0;
+
+	if (m_Grid.FindFirstFit(1, 1, Row, Column))
+	{
+		return true;
+	}
+
+	for (int32 i = GetInventorySlotsCount(); i < m_InventoryItems.Num(); i++)
+	{
+		if (m_InventoryItems[i].IsEmptySlot())
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+int32 UInventoryComponent::GetNextEmptySlot()
+{
+	/*FInventoryItemStack* item = m_InventoryItems.FindByPredicate([](const FInventoryItemStack& Item)
+	{
+		return Item.IsEmptySlot() ? Item : FInventoryItemStack();
+	});
+
+	return GetItemIndex(*item);*/
+
+	/*if (m_InventoryItems.Num() >= GetTotalInventorySlotCount())
+	{
+		PRINT("You have too many slots in your inventory array!");
+		return -1;
+	}*/
+
+	for (int32 i = 0; i < m_InventoryItems.Num(); i++)
+	{
+		if (m_InventoryItems.IsValidIndex(i) && m_InventoryItems[i].IsEmptySlot())
+		{
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+void UInventoryComponent::SplitItemStack(int32 SlotIndex, int32 Quantity)
+{
+	FInventoryOperation Operation(EInventoryOperation::Split, SlotIndex, INDEX_NONE, Quantity);
+	Operation.SlotVersion = GetExpectedSlotVersion(SlotIndex);
+
+	if (GetOwnerRole() < ROLE_Authority)
+	{
+		// The grid only knows about replicated slots, the server has the final say on where it goes
+		int32 TargetIndex = m_bUseFootprints ? GetSplitSlot(SlotIndex) : INDEX_NONE;
+
+		for (int32 i = 0; i < m_InventoryItems.Num() && !m_bUseFootprints; i++)
+		{
+			if (GetDisplayedSlot(i).IsEmptySlot())
+			{
+				TargetIndex = i;
+				break;
+			}
+		}
+
+		FInventoryItemStack Source = GetDisplayedSlot(SlotIndex);
+		FInventoryItemStack Target = GetDisplayedSlot(TargetIndex);
+
+		if (TargetIndex == INDEX_NONE || !SplitStacks(Source, Target, Quantity))
+		{
+			return;
+		}
+
+		const int32 Sequence = QueueOperation(Operation);
+		PredictSlot(SlotIndex, Source, Sequence);
+		PredictSlot(TargetIndex, Target, Sequence);
+		return;
+	}
+
+	QueueOperation(Operation);
+}
+
+bool UInventoryComponent::Server_SplitItemStack_Validate(int32 SlotIndex, int32 Quantity, int32 SlotVersion, int32 Sequence) { return IsValidSlotIndex(SlotIndex) && Quantity > 0 && Sequence >= 0; }
+void UInventoryComponent::Server_SplitItemStack_Implementation(int32 SlotIndex, int32 Quantity, int32 SlotVersion, int32 Sequence)
+{
+	FInventoryOperation Operation(EInventoryOperation::Split, SlotIndex, INDEX_NONE, Quantity);
+	Operation.SlotVersion = SlotVersion;
+
+	ReceiveOperation(Operation, Sequence);
+}
+
+int32 UInventoryComponent::GetExpectedSlotVersion(int32 SlotIndex) const
+{
+	// A predicted slot is based on operations the server may not have applied yet, so the replicated version can't be checked
+	return m_PredictedSlots.Contains(SlotIndex) ? INDEX_NONE : GetSlotVersion(SlotIndex);
+}
+
+bool UInventoryComponent::IsExpectedSlot(int32 SlotIndex, int32 SlotVersion) const
+{
+	return m_InventoryItems.IsValidIndex(SlotIndex) && (SlotVersion == INDEX_NONE || m_InventoryItems[SlotIndex].Version == SlotVersion);
+}
+
+int32 UInventoryComponent::GetSplitSlot(int32 SourceIndex) const
+{
+	if (!m_InventoryItems.IsValidIndex(SourceIndex))
+	{
+		return INDEX_NONE;
+	}
+
+	FInventoryItemStack Split = m_InventoryItems[SourceIndex];
+	return FindSlotFor(Split);
+}
+
+bool UInventoryComponent::ApplySplit(int32 SourceIndex, int32 TargetIndex, int32 Quantity)
+{
+	if (!m_InventoryItems.IsValidIndex(SourceIndex) || !m_InventoryItems.IsValidIndex(TargetIndex))
+	{
+		return false;
+	}
+
+	FInventoryItemStack Source = m_InventoryItems[SourceIndex];
+	FInventoryItemStack Target = m_InventoryItems[TargetIndex];
+
+	if (!SplitStacks(Source, Target, Quantity))
+	{
+		return false;
+	}
+
+	if (m_bUseFootprints)
+	{
+		TArray<TPair<int32, FInventoryItemStack>> Placements;
+		Placements.Emplace(TargetIndex, Target);
+
+		if (!FitsInGrid(Placements))
+		{
+			// Try it the other way around before giving up
+			if (!Target.InventoryItem.bCanRotate)
+			{
+				return false;
+			}
+
+			Placements[0].Value.bRotated = Target.bRotated = !Target.bRotated;
+
+			if (!FitsInGrid(Placements))
+			{
+				return false;
+			}
+		}
+	}
+
+	SetSlot(SourceIndex, Source);
+	SetSlot(TargetIndex, Target);
+
+	return true;
+}
+
+int32 UInventoryComponent::GetCountOfItem(const FInventoryItem& Item)
+{
+	int32 count = 0;
+
+	// TODO: Update this with a better algo as this is VERY slow
+	// https://www.geeksforgeeks.org/count-number-of-occurrences-or-frequency-in-a-sorted-array/
+	for (FInventoryItemStack& item : m_InventoryItems)
+	{
+		if (item.InventoryItem == Item)
+		{
+			count++;
+		}
+	}
+
+	return count;
+}
+
+void UInventoryComponent::CombineItemStack(int32 ItemToCombine, int32 TargetItem)
+{
+	if (GetOwnerRole() < ROLE_Authority)
+	{
+		FInventoryItemStack Source = GetDisplayedSlot(ItemToCombine);
+		FInventoryItemStack Target = GetDisplayedSlot(TargetItem);
+
+		if (!CombineStacks(Source, Target, GetInventoryTime()))
+		{
+			return;
+		}
+
+		const int32 Sequence = QueueOperation(FInventoryOperation(EInventoryOperation::Combine, ItemToCombine, TargetItem));
+		PredictSlot(ItemToCombine, Source, Sequence);
+		PredictSlot(TargetItem, Target, Sequence);
+		return;
+	}
+
+	QueueOperation(FInventoryOperation(EInventoryOperation::Combine, ItemToCombine, TargetItem));
+}
+
+bool UInventoryComponent::Server_CombineItemStack_Validate(int32 ItemToCombine, int32 TargetItem, int32 Sequence) { return IsValidSlotIndex(ItemToCombine) && IsValidSlotIndex(TargetItem) && Sequence >= 0; }
+void UInventoryComponent::Server_CombineItemStack_Implementation(int32 ItemToCombine, int32 TargetItem, int32 Sequence)
+{
+	ReceiveOperation(FInventoryOperation(EInventoryOperation::Combine, ItemToCombine, TargetItem), Sequence);
+}
+
+bool UInventoryComponent::ApplyCombine(int32 ItemToCombine, int32 TargetItem)
+{
+	if (ItemToCombine == TargetItem || !m_InventoryItems.IsValidIndex(ItemToCombine) || !m_InventoryItems.IsValidIndex(TargetItem))
+	{
+		return false;
+	}
+
+	FInventoryItemStack tmpTargetItem = m_InventoryItems[TargetItem];
+	FInventoryItemStack tmpItemToCombine = m_InventoryItems[ItemToCombine];
+
+	if (!CombineStacks(tmpItemToCombine, tmpTargetItem, GetInventoryTime()))
+	{
+		return false;
+	}
+
+	SetSlot(TargetItem, tmpTargetItem);
+	SetSlot(ItemToCombine, tmpItemToCombine);
+
+	// PRINT("TargetItem: " + FString::FromInt(tmpIndex) + ", ItemToCombine: " + FString::FromInt(tmpIndex2));
+
+	// if (m_InventoryItems.IsValidIndex(tmpIndex) && m_InventoryItems.IsValidIndex(tmpIndex2))
+	//{
+	//	// TODO: Clamp the stack
+	//	TmpItem.StackSize += ItemToCombine.StackSize;
+	//	TmpItem2.StackSize -= ItemToCombine.StackSize;
+
+	//	m_InventoryItems[tmpIndex] = TmpItem;
+	//	m_InventoryItems[tmpIndex2] = TmpItem2;
+
+	//	PRINT("New Size : " + FString::FromInt(TargetItem.StackSize) + " Index: " + FString::FromInt(GetItemIndex(TargetItem)));
+
+	//	if (ItemToCombine.StackSize <= 0)
+	//	{
+	//		RemoveItem(ItemToCombine);
+	//	}
+	//}
+
+	return true;
+}
+
+void UInventoryComponent::SortAndConsolidate(EInventorySortKey SortKey, bool bDescending)
+{
+	// Not predicted, the whole layout changes and the server knows best where everything ends up
+	QueueOperation(FInventoryOperation(EInventoryOperation::Sort, (int32)SortKey, INDEX_NONE, bDescending ? 1 : 0));
+}
+
+bool UInventoryComponent::Server_SortAndConsolidate_Validate(EInventorySortKey SortKey, bool bDescending, int32 Sequence) { return SortKey <= EInventorySortKey::ISK_StackSize && Sequence >= 0; }
+void UInventoryComponent::Server_SortAndConsolidate_Implementation(EInventorySortKey SortKey, bool bDescending, int32 Sequence)
+{
+	ReceiveOperation(FInventoryOperation(EInventoryOperation::Sort, (int32)SortKey, INDEX_NONE, bDescending ? 1 : 0), Sequence);
+}
+
+bool UInventoryComponent::ApplySortAndConsolidate(EInventorySortKey SortKey, bool bDescending)
+{
+	const int32 SlotCount = FMath::Min(GetInventorySlotsCount(), m_InventoryItems.Num());
+	if (SlotCount <= 0)
+	{
+		return false;
+	}
+
+	const float Now = GetInventoryTime();
+
+	// Merge in one pass, every stack tops up the partial stack of its item that came before it
+	TArray<FInventoryItemStack> Stacks;
+	Stacks.Reserve(SlotCount);
+
+	TMap<FName, int32> PartialStacks;
+
+	for (int32 i = 0; i < SlotCount; i++)
+	{
+		if (m_InventoryItems[i].IsEmptySlot())
+		{
+			continue;
+		}
+
+		FInventoryItemStack Stack = m_InventoryItems[i];
+
+		if (!Stack.InventoryItem.bAutoStack || !Stack.InventoryItem.CanStack() || Stack.HasInstanceData())
+		{
+			Stacks.Add(Stack);
+			continue;
+		}
+
+		const FName Key = Stack.InventoryItem.GetKey();
+
+		if (const int32* const Partial = PartialStacks.Find(Key))
+		{
+			CombineStacks(Stack, Stacks[*Partial], Now);
+
+			if (Stack.IsEmptySlot())
+			{
+				continue;
+			}
+		}
+
+		// Whatever is left over only stays behind once the partial stack before it is full
+		if (Stack.GetEmptySizeLeft() > 0)
+		{
+			PartialStacks.Add(Key, Stacks.Num());
+		}
+
+		Stacks.Add(Stack);
+	}
+
+	Stacks.StableSort([SortKey, bDescending](const FInventoryItemStack& A, const FInventoryItemStack& B)
+	{
+		const int32 IDOrder = A.InventoryItem.GetKey().Compare(B.InventoryItem.GetKey());
+
+		int32 Order = 0;
+		switch (SortKey)
+		{
+		case EInventorySortKey::ISK_ItemID:
+			Order = IDOrder;
+			break;
+		case EInventorySortKey::ISK_Category:
+			Order = (int32)A.InventoryItem.ItemAction - (int32)B.InventoryItem.ItemAction;
+			break;
+		case EInventorySortKey::ISK_Weight:
+			Order = A.GetWeight() < B.GetWeight() ? -1 : (A.GetWeight() > B.GetWeight() ? 1 : 0);
+			break;
+		case EInventorySortKey::ISK_StackSize:
+			Order = A.StackSize - B.StackSize;
+			break;
+		}
+
+		if (bDescending)
+		{
+			Order = -Order;
+		}
+
+		return (Order != 0 ? Order : IDOrder) < 0;
+	});
+
+	// Lay the sorted stacks out from the first slot
+	TArray<FInventoryItemStack> Sorted;
+	Sorted.SetNum(SlotCount);
+
+	if (m_bUseFootprints)
+	{
+		FInventoryGrid Grid;
+		Grid.Reset(m_InventoryRowsNum, m_InventoryColumnsNum);
+
+		for (FInventoryItemStack& Stack : Stacks)
+		{
+			int32 Row = 0, Column = 0;
+			FIntPoint Size = Stack.GetFootprint();
+
+			if (!Grid.FindFirstFit(Size.X, Size.Y, Row, Column))
+			{
+				Stack.bRotated = !Stack.bRotated;
+				Size = Stack.GetFootprint();
+
+				// Packing in a different order can leave holes, keep the layout the player has
+				if (!Stack.InventoryItem.bCanRotate || !Grid.FindFirstFit(Size.X, Size.Y, Row, Column))
+				{
+					return false;
+				}
+			}
+
+			Grid.Set(Row, Column, Size.X, Size.Y, true);
+			Sorted[Row * m_InventoryColumnsNum + Column] = Stack;
+		}
+	}
+	else
+	{
+		for (int32 i = 0; i < Stacks.Num(); i++)
+		{
+			Sorted[i] = Stacks[i];
+		}
+	}
+
+	TArray<int32, TInlineAllocator<64>> Changed;
+
+	for (int32 i = 0; i < SlotCount; i++)
+	{
+		const FInventoryItemStack& Current = m_InventoryItems[i];
+		const FInventoryItemStack& New = Sorted[i];
+
+		const bool bSame = Current.IsEmptySlot() ? New.IsEmptySlot() : !New.IsEmptySlot() && Current == New && Current.StackSize == New.StackSize
+			&& Current.InstanceID == New.InstanceID && Current.bRotated == New.bRotated && Current.Condition == New.Condition && Current.ConditionTime == New.ConditionTime;
+
+		if (!bSame)
+		{
+			Changed.Add(i);
+		}
+	}
+
+	if (Changed.Num() == 0)
+	{
+		return true;
+	}
+
+	// One change event for the whole thing, and it all goes out in the same net update
+	FInventoryChangeBatch Batch(this);
+
+	// Empty every slot that changes before filling any so no footprint is taken off the grid after another stack was put over it
+	for (int32 Index : Changed)
+	{
+		SetSlot(Index, FInventoryItemStack());
+	}
+
+	for (int32 Index : Changed)
+	{
+		if (!Sorted[Index].IsEmptySlot())
+		{
+			SetSlot(Index, Sorted[Index]);
+		}
+	}
+
+	return true;
 }
 
-bool UInventoryComponent::Server_CombineItemStack_Validate(int32 ItemToCombine, int32 TargetItem) { return true; }
-void UInventoryComponent::Server_CombineItemStack_Implementation(int32 ItemToCombine, int32 TargetItem)
+bool UInventoryComponent::SwapStacks(FInventoryItemStack& Current, FInventoryItemStack& New)
 {
-	FInventoryItemStack tmpTargetItem = m_InventoryItems[TargetItem];
-	FInventoryItemStack tmpItemToCombine = m_InventoryItems[ItemToCombine];
+	if (Current.IsEmptySlot() && New.IsEmptySlot())
+	{
+		return false;
+	}
+
+	Swap(Current, New);
+
+	return true;
+}
+
+bool UInventoryComponent::CombineStacks(FInventoryItemStack& Source, FInventoryItemStack& Target, float Now)
+{
+	if (Source.IsEmptySlot() || Target.IsEmptySlot() || !(Source == Target) || !Target.InventoryItem.CanStack() || Source.HasInstanceData() || Target.HasInstanceData())
+	{
+		return false;
+	}
+
+	// Only move what the target has room for, the rest stays in the source
+	const int32 CountToMove = FMath::Min(Source.StackSize, Target.GetEmptySizeLeft());
+	if (CountToMove <= 0)
+	{
+		return false;
+	}
+
+	Target.MergeCondition(Source, CountToMove, Now);
+	Target.StackSize += CountToMove;
+	Source.StackSize -= CountToMove;
+
+	if (Source.StackSize <= 0)
+	{
+		Source = FInventoryItemStack();
+	}
+
+	return true;
+}
+
+bool UInventoryComponent::SplitStacks(FInventoryItemStack& Source, FInventoryItemStack& Target, int32 Quantity)
+{
+	if (Source.IsEmptySlot() || !Target.IsEmptySlot() || Quantity <= 0 || Quantity >= Source.StackSize || Source.HasInstanceData())
+	{
+		return false;
+	}
+
+	Target = Source;
+	Target.StackSize = Quantity;
+	Source.StackSize -= Quantity;
+
+	return true;
+}
+
+const FInventoryItemStack& UInventoryComponent::GetDisplayedSlot(int32 SlotIndex) const
+{
+	if (const FPredictedSlot* Predicted = m_PredictedSlots.Find(SlotIndex))
+	{
+		return Predicted->Stack;
+	}
+
+	static const FInventoryItemStack EmptyStack;
+	return m_InventoryItems.IsValidIndex(SlotIndex) ? m_InventoryItems[SlotIndex] : EmptyStack;
+}
+
+void UInventoryComponent::PredictSlot(int32 SlotIndex, const FInventoryItemStack& Stack, int32 PredictionKey)
+{
+	if (!m_InventoryItems.IsValidIndex(SlotIndex))
+	{
+		return;
+	}
+
+	FPredictedSlot& Predicted = m_PredictedSlots.FindOrAdd(SlotIndex);
+	Predicted.Stack = Stack;
+	Predicted.PredictionKey = PredictionKey;
+	Predicted.BaseVersion = m_InventoryItems[SlotIndex].Version;
+	Predicted.Time = 0.0f;
+	Predicted.bConfirmed = false;
+
+	OnSlotChanged.Broadcast(SlotIndex);
+}
+
+void UInventoryComponent::Client_AckOperation_Implementation(int32 Sequence, const TArray<int32>& Rejected)
+{
+	// The server applies operations in order so this acknowledges everything before it too
+	m_UnackedOperations.RemoveAll([Sequence](const FInventoryOperation& Operation)
+	{
+		return Operation.Sequence <= Sequence;
+	});
+
+	if (m_UnackedOperations.Num() == 0)
+	{
+		GetWorld()->GetTimerManager().ClearTimer(m_ResendTimer);
+	}
 
-	PRINT("TargetItem: " + FString::FromInt(TargetItem) + ", ItemToCombine: " + FString::FromInt(ItemToCombine));
+	const float Now = GetWorld()->GetTimeSeconds();
 
-	if (tmpItemToCombine == tmpTargetItem && tmpTargetItem.InventoryItem.CanStack() && tmpTargetItem.StackSize < tmpTargetItem.InventoryItem.MaxStackSize)
+	for (auto It = m_PredictedSlots.CreateIterator(); It; ++It)
 	{
-		tmpTargetItem.StackSize += tmpItemToCombine.StackSize;
-		tmpItemToCombine.StackSize -= tmpItemToCombine.StackSize;
+		FPredictedSlot& Predicted = It->Value;
 
-		m_InventoryItems[TargetItem] = tmpTargetItem;
-		m_InventoryItems[ItemToCombine] = tmpItemToCombine;
+		if (Predicted.PredictionKey > Sequence)
+		{
+			continue;
+		}
 
-		if (tmpItemToCombine.StackSize <= 0)
+		if (Rejected.Contains(Predicted.PredictionKey))
+		{
+			// Roll back to the replicated slot
+			const int32 SlotIndex = It->Key;
+			It.RemoveCurrent();
+			OnSlotChanged.Broadcast(SlotIndex);
+		}
+		else if (!Predicted.bConfirmed)
 		{
-			RemoveItemBySlot(ItemToCombine);
-			// RemoveItem(tmpItemToCombine);
+			// Keep showing the prediction until the authoritative slot arrives so it doesn't flicker back
+			Predicted.bConfirmed = true;
+			Predicted.Time = Now;
 		}
 	}
 
-	// PRINT("TargetItem: " + FString::FromInt(tmpIndex) + ", ItemToCombine: " + FString::FromInt(tmpIndex2));
+	PrunePredictions();
 
-	// if (m_InventoryItems.IsValidIndex(tmpIndex) && m_InventoryItems.IsValidIndex(tmpIndex2))
-	//{
-	//	// TODO: Clamp the stack
-	//	TmpItem.StackSize += ItemToCombine.StackSize;
-	//	TmpItem2.StackSize -= ItemToCombine.StackSize;
+	if (m_PredictedSlots.Num() > 0 && !GetWorld()->GetTimerManager().IsTimerActive(m_PredictionTimer))
+	{
+		GetWorld()->GetTimerManager().SetTimer(m_PredictionTimer, this, &UInventoryComponent::PrunePredictions, PredictionTimeout, true);
+	}
+}
 
-	//	m_InventoryItems[tmpIndex] = TmpItem;
-	//	m_InventoryItems[tmpIndex2] = TmpItem2;
+void UInventoryComponent::ViewStashPage(UInventoryStashComponent* Stash, int32 Page)
+{
+	if (Stash == nullptr)
+	{
+		return;
+	}
 
-	//	PRINT("New Size : " + FString::FromInt(TargetItem.StackSize) + " Index: " + FString::FromInt(GetItemIndex(TargetItem)));
+	if (GetOwnerRole() < ROLE_Authority)
+	{
+		Server_ViewStashPage(Stash, Page);
+		return;
+	}
 
-	//	if (ItemToCombine.StackSize <= 0)
-	//	{
-	//		RemoveItem(ItemToCombine);
-	//	}
-	//}
+	Stash->SetViewerPage(this, Page);
+}
+
+bool UInventoryComponent::Server_ViewStashPage_Validate(UInventoryStashComponent* Stash, int32 Page) { return Page >= INDEX_NONE; }
+void UInventoryComponent::Server_ViewStashPage_Implementation(UInventoryStashComponent* Stash, int32 Page)
+{
+	UInventorySubsystem* const Subsystem = GetWorld()->GetSubsystem<UInventorySubsystem>();
+	if (Subsystem && !Subsystem->ConsumeOperationBudget(GetOwner()->GetNetConnection()))
+	{
+		return;
+	}
+
+	if (Stash)
+	{
+		Stash->SetViewerPage(this, Page);
+	}
+}
+
+void UInventoryComponent::Client_ReceiveStashSlots_Implementation(UInventoryStashComponent* Stash, const TArray<FInventorySlotUpdate>& Slots)
+{
+	if (Stash)
+	{
+		Stash->ReceiveSlots(Slots);
+	}
+}
+
+void UInventoryComponent::PrunePredictions()
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+
+	for (auto It = m_PredictedSlots.CreateIterator(); It; ++It)
+	{
+		const int32 SlotIndex = It->Key;
+		const FPredictedSlot& Predicted = It->Value;
+
+		// Predictions for operations that are still being re-sent stay until the server answers
+		if (!Predicted.bConfirmed)
+		{
+			continue;
+		}
+
+		const bool bReplicated = m_InventoryItems.IsValidIndex(SlotIndex) && m_InventoryItems[SlotIndex].Version != Predicted.BaseVersion;
+		const bool bTimedOut = Now - Predicted.Time > PredictionTimeout;
+
+		if (bReplicated || bTimedOut)
+		{
+			It.RemoveCurrent();
+			OnSlotChanged.Broadcast(SlotIndex);
+		}
+	}
+
+	if (m_PredictedSlots.Num() == 0)
+	{
+		GetWorld()->GetTimerManager().ClearTimer(m_PredictionTimer);
+	}
+}
+
+int32 UInventoryComponent::QueueOperation(FInventoryOperation Operation)
+{
+	if (GetOwnerRole() == ROLE_Authority)
+	{
+		SendOperation(Operation);
+		return 0;
+	}
+
+	Operation.Sequence = ++m_LastSentSequence;
+
+	FInventoryOperation& Queued = m_UnackedOperations.Add_GetRef(Operation);
+	SendOperation(Queued);
+
+	if (!GetWorld()->GetTimerManager().IsTimerActive(m_ResendTimer))
+	{
+		GetWorld()->GetTimerManager().SetTimer(m_ResendTimer, this, &UInventoryComponent::ResendOperations, OperationResendInterval, true);
+	}
+
+	return Operation.Sequence;
+}
+
+void UInventoryComponent::SendOperation(FInventoryOperation& Operation)
+{
+	Operation.LastSentTime = GetWorld()->GetTimeSeconds();
+
+	switch (Operation.Type)
+	{
+	case EInventoryOperation::Swap:
+		Server_SwapItem(Operation.FirstIndex, Operation.SecondIndex, Operation.Sequence);
+		break;
+	case EInventoryOperation::Combine:
+		Server_CombineItemStack(Operation.FirstIndex, Operation.SecondIndex, Operation.Sequence);
+		break;
+	case EInventoryOperation::Split:
+		Server_SplitItemStack(Operation.FirstIndex, Operation.Quantity, Operation.SlotVersion, Operation.Sequence);
+		break;
+	case EInventoryOperation::Drop:
+		Server_DropItem(Operation.FirstIndex, Operation.Quantity, Operation.Sequence);
+		break;
+	case EInventoryOperation::Exec:
+		Server_ExecItem(Operation.FirstIndex, Operation.SlotVersion, Operation.Sequence);
+		break;
+	case EInventoryOperation::Sort:
+		Server_SortAndConsolidate((EInventorySortKey)Operation.FirstIndex, Operation.Quantity != 0, Operation.Sequence);
+		break;
+	case EInventoryOperation::Craft:
+		Server_CraftRecipe(Operation.FirstIndex, Operation.Quantity, Operation.Sequence);
+		break;
+	}
+}
+
+void UInventoryComponent::ResendOperations()
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+
+	// Re-send in order, the server only applies the next operation it's expecting
+	for (FInventoryOperation& Operation : m_UnackedOperations)
+	{
+		if (Now - Operation.LastSentTime >= OperationResendInterval)
+		{
+			SendOperation(Operation);
+		}
+	}
+}
+
+bool UInventoryComponent::ShouldApplyOperation(int32 Sequence)
+{
+	// Called on the server directly
+	if (Sequence == 0)
+	{
+		return true;
+	}
+
+	// Already applied, the ack must have been lost so send it again
+	if (Sequence <= m_LastAppliedSequence)
+	{
+		Client_AckOperation(m_LastAppliedSequence, m_RejectedSequences);
+		return false;
+	}
+
+	// Already queued for this frame, it's acknowledged when it's applied
+	if (Sequence <= m_LastReceivedSequence)
+	{
+		return false;
+	}
+
+	// An earlier operation was lost, wait for the client to re-send it so operations are applied in order
+	return Sequence == m_LastReceivedSequence + 1;
+}
+
+void UInventoryComponent::ReceiveOperation(FInventoryOperation Operation, int32 Sequence)
+{
+	// Over budget, a well behaved client will re-send it later
+	UInventorySubsystem* const Subsystem = GetWorld()->GetSubsystem<UInventorySubsystem>();
+	if (Subsystem && !Subsystem->ConsumeOperationBudget(GetOwner()->GetNetConnection()))
+	{
+		return;
+	}
+
+	if (!ShouldApplyOperation(Sequence))
+	{
+		return;
+	}
+
+	Operation.Sequence = Sequence;
+
+	if (Sequence != 0)
+	{
+		m_LastReceivedSequence = Sequence;
+	}
+
+	// Apply everything that arrives this frame together so redundant operations can cancel out
+	if (m_PendingOperations.Num() == 0)
+	{
+		GetWorld()->GetTimerManager().SetTimerForNextTick(this, &UInventoryComponent::FlushOperations);
+	}
+
+	m_PendingOperations.Add(Operation);
+}
+
+void UInventoryComponent::FlushOperations()
+{
+	TArray<FInventoryOperation> Operations = MoveTemp(m_PendingOperations);
+	m_PendingOperations.Reset();
+
+	TArray<FInventoryOperation, TInlineAllocator<16>> Coalesced;
+	int32 CoalescedCount = 0;
+	int32 LastSequence = 0;
+
+	// The sequences merged into each coalesced operation, they're accepted or rejected along with it
+	TMap<int32, TArray<int32, TInlineAllocator<4>>> MergedSequences;
+
+	for (const FInventoryOperation& Operation : Operations)
+	{
+		LastSequence = FMath::Max(LastSequence, Operation.Sequence);
+
+		// Swapping the same 2 slots twice in a row does nothing
+		if (Coalesced.Num() > 0 && Operation.Type == EInventoryOperation::Swap && Coalesced.Last().Type == EInventoryOperation::Swap)
+		{
+			const FInventoryOperation& Previous = Coalesced.Last();
+
+			const bool bSamePair = (Previous.FirstIndex == Operation.FirstIndex && Previous.SecondIndex == Operation.SecondIndex)
+				|| (Previous.FirstIndex == Operation.SecondIndex && Previous.SecondIndex == Operation.FirstIndex);
+
+			if (bSamePair)
+			{
+				Coalesced.Pop(false);
+				CoalescedCount += 2;
+				continue;
+			}
+		}
+
+		// Sorting again the same way straight after changes nothing
+		if (Coalesced.Num() > 0 && Operation.Type == EInventoryOperation::Sort && Coalesced.Last().Type == EInventoryOperation::Sort
+			&& Coalesced.Last().FirstIndex == Operation.FirstIndex && Coalesced.Last().Quantity == Operation.Quantity)
+		{
+			MergedSequences.FindOrAdd(Coalesced.Num() - 1).Add(Operation.Sequence);
+			CoalescedCount++;
+			continue;
+		}
+
+		Coalesced.Add(Operation);
+	}
+
+	if (CoalescedCount > 0)
+	{
+		if (UInventorySubsystem* const Subsystem = GetWorld()->GetSubsystem<UInventorySubsystem>())
+		{
+			Subsystem->RecordCoalescedOperations(GetOwner()->GetNetConnection(), CoalescedCount);
+		}
+	}
+
+	for (int32 i = 0; i < Coalesced.Num(); i++)
+	{
+		if (ApplyOperation(Coalesced[i]))
+		{
+			continue;
+		}
+
+		RejectOperation(Coalesced[i].Sequence);
+
+		if (const TArray<int32, TInlineAllocator<4>>* const Merged = MergedSequences.Find(i))
+		{
+			for (int32 Sequence : *Merged)
+			{
+				RejectOperation(Sequence);
+			}
+		}
+	}
+
+	// Everything is acknowledged together, the rejections go with it
+	AckOperation(LastSequence);
+}
+
+bool UInventoryComponent::ApplyOperation(const FInventoryOperation& Operation)
+{
+	switch (Operation.Type)
+	{
+	case EInventoryOperation::Swap:
+		return ApplySwap(Operation.FirstIndex, Operation.SecondIndex);
+	case EInventoryOperation::Combine:
+		return ApplyCombine(Operation.FirstIndex, Operation.SecondIndex);
+	case EInventoryOperation::Split:
+		return IsExpectedSlot(Operation.FirstIndex, Operation.SlotVersion) && ApplySplit(Operation.FirstIndex, GetSplitSlot(Operation.FirstIndex), Operation.Quantity);
+	case EInventoryOperation::Drop:
+		return ApplyDrop(Operation.FirstIndex, Operation.Quantity);
+	case EInventoryOperation::Exec:
+		return ApplyExec(Operation.FirstIndex, Operation.SlotVersion);
+	case EInventoryOperation::Sort:
+		return ApplySortAndConsolidate((EInventorySortKey)Operation.FirstIndex, Operation.Quantity != 0);
+	case EInventoryOperation::Craft:
+		return ApplyCraft(Operation.FirstIndex, Operation.Quantity);
+	}
+
+	return false;
+}
+
+void UInventoryComponent::AckOperation(int32 Sequence)
+{
+	if (Sequence == 0)
+	{
+		return;
+	}
+
+	m_LastAppliedSequence = Sequence;
+
+	Client_AckOperation(Sequence, m_RejectedSequences);
 }
 
+void UInventoryComponent::RejectOperation(int32 Sequence)
+{
+	if (Sequence == 0)
+	{
+		return;
+	}
+
+	// Acks are unreliable, so the client can't be told once and forgotten about
+	if (m_RejectedSequences.Num() >= MaxAckedRejections)
+	{
+		m_RejectedSequences.RemoveAt(0, m_RejectedSequences.Num() - MaxAckedRejections + 1, false);
+	}
+
+	m_RejectedSequences.Add(Sequence);
+}
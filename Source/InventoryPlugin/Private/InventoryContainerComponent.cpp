@@ -0,0 +1,160 @@
+/**
+ * Copyright 2019-2020 - Russ 'trdwll' Treadwell https://trdwll.com
+ */
+
+
+#include "InventoryContainerComponent.h"
+
+#include "InventoryLootTable.h"
+
+#include "Engine/World.h"
+#include "TimerManager.h"
+
+UInventoryContainerComponent::UInventoryContainerComponent()
+{
+	m_LootTable = nullptr;
+	m_LootSeed = 0;
+	m_ReleaseDelay = 60.0f;
+	m_bGenerated = false;
+	m_OpenCount = 0;
+	m_bRestoring = false;
+	m_bMaterializing = false;
+}
+
+void UInventoryContainerComponent::InitializeSlots()
+{
+	// Nothing until someone opens or queries it
+}
+
+void UInventoryContainerComponent::PrepareSlots() const
+{
+	if (m_bMaterializing || GetOwnerRole() != ROLE_Authority)
+	{
+		return;
+	}
+
+	// Creating the slots doesn't change what's in the container, only how it's stored
+	const_cast<UInventoryContainerComponent*>(this)->EnsureMaterialized();
+}
+
+void UInventoryContainerComponent::GenerateContents_Implementation(TArray<FInventoryItemMeta>& OutContents)
+{
+	OutContents = m_Loot;
+
+	if (m_LootTable)
+	{
+		FRandomStream Stream(m_LootSeed != 0 ? m_LootSeed : FMath::Rand());
+		m_LootTable->Roll(Stream, OutContents);
+	}
+}
+
+void UInventoryContainerComponent::EnsureMaterialized()
+{
+	if (GetOwnerRole() != ROLE_Authority)
+	{
+		return;
+	}
+
+	if (!HasSlots() && !m_bMaterializing)
+	{
+		TGuardValue<bool> MaterializingGuard(m_bMaterializing, true);
+
+		AllocateSlots();
+
+		TArray<FInventoryItemMeta> Contents;
+		if (m_bGenerated)
+		{
+			Contents = MoveTemp(m_StoredContents);
+			m_StoredContents.Empty();
+		}
+		else
+		{
+			GenerateContents(Contents);
+		}
+
+		m_bRestoring = m_bGenerated;
+		AddItems(Contents);
+
+		m_bRestoring = false;
+		m_bGenerated = true;
+	}
+
+	// Being queried counts as being used
+	if (m_OpenCount == 0)
+	{
+		ScheduleRelease();
+	}
+}
+
+void UInventoryContainerComponent::OpenContainer()
+{
+	EnsureMaterialized();
+
+	m_OpenCount++;
+	GetWorld()->GetTimerManager().ClearTimer(m_ReleaseTimer);
+}
+
+void UInventoryContainerComponent::CloseContainer()
+{
+	m_OpenCount = FMath::Max(0, m_OpenCount - 1);
+
+	if (m_OpenCount == 0)
+	{
+		ScheduleRelease();
+	}
+}
+
+void UInventoryContainerComponent::ScheduleRelease()
+{
+	if (m_ReleaseDelay > 0.0f)
+	{
+		GetWorld()->GetTimerManager().SetTimer(m_ReleaseTimer, this, &UInventoryContainerComponent::Dehydrate, m_ReleaseDelay, false);
+	}
+}
+
+void UInventoryContainerComponent::Dehydrate()
+{
+	if (m_OpenCount > 0 || !HasSlots())
+	{
+		return;
+	}
+
+	// Keep the slots rather than lose anything
+	TArray<FInventoryItemMeta> Contents;
+	if (!ExportContents(Contents))
+	{
+		return;
+	}
+
+	m_StoredContents = MoveTemp(Contents);
+	ReleaseSlots();
+}
+
+bool UInventoryContainerComponent::ExportContents(TArray<FInventoryItemMeta>& OutContents) const
+{
+	if (!HasSlots())
+	{
+		OutContents = m_StoredContents;
+		return true;
+	}
+
+	OutContents.Reset();
+
+	for (const FInventoryItemStack& Stack : GetInventoryItems())
+	{
+		if (Stack.IsEmptySlot())
+		{
+			continue;
+		}
+
+		// Can't be rebuilt from the DataTable or has state the compact form can't hold
+		if (Stack.InventoryItem.ID.IsNone() || Stack.InventoryItem.HasCondition() || Stack.HasInstanceData())
+		{
+			return false;
+		}
+
+		OutContents.Emplace(Stack.InventoryItem.ID, Stack.StackSize);
+	}
+
+	return true;
+}
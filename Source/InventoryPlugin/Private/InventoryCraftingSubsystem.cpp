@@ -0,0 +1,45 @@
+/**
+ * Copyright 2019-2020 - Russ 'trdwll' Treadwell https://trdwll.com
+ */
+
+
+#include "InventoryCraftingSubsystem.h"
+
+#include "InventoryPluginSettings.h"
+#include "InventoryRecipe.h"
+
+void UInventoryCraftingSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	const UInventoryPluginSettings* const Settings = GetDefault<UInventoryPluginSettings>();
+	if (Settings == nullptr)
+	{
+		return;
+	}
+
+	// Recipes are small and needed by every inventory from the start
+	for (const TSoftObjectPtr<UInventoryRecipe>& RecipePtr : Settings->m_Recipes)
+	{
+		UInventoryRecipe* const Recipe = RecipePtr.LoadSynchronous();
+		if (Recipe == nullptr)
+		{
+			continue;
+		}
+
+		const int32 RecipeIndex = m_Recipes.Add(Recipe);
+
+		for (const FInventoryItemMeta& Input : Recipe->m_Inputs)
+		{
+			m_RecipesByInput.FindOrAdd(Input.ItemRowName).AddUnique(RecipeIndex);
+		}
+	}
+}
+
+void UInventoryCraftingSubsystem::Deinitialize()
+{
+	m_Recipes.Empty();
+	m_RecipesByInput.Empty();
+
+	Super::Deinitialize();
+}
@@ -0,0 +1,109 @@
+/**
+ * Copyright 2019-2020 - Russ 'trdwll' Treadwell https://trdwll.com
+ */
+
+
+#include "InventoryGridWidget.h"
+
+#include "Components/UniformGridPanel.h"
+#include "Components/UniformGridSlot.h"
+
+UInventoryGridWidget::UInventoryGridWidget(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
+{
+	m_VisibleRows = 5;
+	m_FirstVisibleRow = 0;
+}
+
+void UInventoryGridWidget::NativeConstruct()
+{
+	Super::NativeConstruct();
+
+	BuildPool();
+	AssignSlots();
+}
+
+FReply UInventoryGridWidget::NativeOnMouseWheel(const FGeometry& InGeometry, const FPointerEvent& InMouseEvent)
+{
+	ScrollToRow(m_FirstVisibleRow - FMath::RoundToInt(InMouseEvent.GetWheelDelta()));
+
+	return FReply::Handled();
+}
+
+void UInventoryGridWidget::SetInventory(UInventoryComponent* Inventory)
+{
+	m_Inventory = Inventory;
+	m_FirstVisibleRow = 0;
+
+	BuildPool();
+	AssignSlots();
+}
+
+void UInventoryGridWidget::ScrollToRow(int32 Row)
+{
+	const int32 NewRow = FMath::Clamp(Row, 0, FMath::Max(0, GetTotalRows() - m_VisibleRows));
+
+	if (NewRow != m_FirstVisibleRow)
+	{
+		m_FirstVisibleRow = NewRow;
+		AssignSlots();
+	}
+}
+
+int32 UInventoryGridWidget::GetTotalRows() const
+{
+	if (m_Inventory == nullptr || m_Inventory->GetInventoryColumnsCount() == 0)
+	{
+		return 0;
+	}
+
+	return FMath::DivideAndRoundUp(m_Inventory->GetInventorySlotsCount(), (int32)m_Inventory->GetInventoryColumnsCount());
+}
+
+void UInventoryGridWidget::BuildPool()
+{
+	if (SlotGrid == nullptr || m_Inventory == nullptr || m_SlotWidgetClass == nullptr)
+	{
+		return;
+	}
+
+	const int32 Columns = m_Inventory->GetInventoryColumnsCount();
+	const int32 PoolSize = FMath::Min(m_VisibleRows, GetTotalRows()) * Columns;
+
+	if (m_SlotPool.Num() == PoolSize)
+	{
+		return;
+	}
+
+	SlotGrid->ClearChildren();
+	m_SlotPool.Reset(PoolSize);
+
+	for (int32 i = 0; i < PoolSize; i++)
+	{
+		UInventorySlotWidget* const SlotWidget = CreateWidget<UInventorySlotWidget>(this, m_SlotWidgetClass);
+		if (SlotWidget)
+		{
+			SlotGrid->AddChildToUniformGrid(SlotWidget, i / Columns, i % Columns);
+			m_SlotPool.Add(SlotWidget);
+		}
+	}
+}
+
+void UInventoryGridWidget::AssignSlots()
+{
+	if (m_Inventory == nullptr)
+	{
+		return;
+	}
+
+	const int32 FirstSlot = m_FirstVisibleRow * m_Inventory->GetInventoryColumnsCount();
+	const int32 SlotCount = m_Inventory->GetInventorySlotsCount();
+
+	for (int32 i = 0; i < m_SlotPool.Num(); i++)
+	{
+		const int32 SlotID = FirstSlot + i;
+
+		// The last row might not be full
+		m_SlotPool[i]->SetVisibility(SlotID < SlotCount ? ESlateVisibility::Visible : ESlateVisibility::Hidden);
+		m_SlotPool[i]->SetSlot(m_Inventory, SlotID);
+	}
+}
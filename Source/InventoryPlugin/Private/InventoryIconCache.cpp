@@ -0,0 +1,126 @@
+/**
+ * Copyright 2019-2020 - Russ 'trdwll' Treadwell https://trdwll.com
+ */
+
+
+#include "InventoryIconCache.h"
+
+#include "InventoryPluginSettings.h"
+#include "InventorySystem.h"
+
+#include "Engine/AssetManager.h"
+#include "Engine/Texture2D.h"
+
+void UInventoryIconCache::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	const UInventoryPluginSettings* const Settings = GetDefault<UInventoryPluginSettings>();
+
+	m_MaxIcons = Settings ? FMath::Max(1, Settings->m_IconCacheSize) : 128;
+
+	// The placeholder is tiny and needed straight away so just load it
+	m_Placeholder = Settings ? Settings->m_PlaceholderIcon.LoadSynchronous() : nullptr;
+}
+
+void UInventoryIconCache::Deinitialize()
+{
+	m_Icons.Empty();
+	m_LRU.Empty();
+	m_LRUNodes.Empty();
+	m_PendingLoads.Empty();
+
+	Super::Deinitialize();
+}
+
+UTexture2D* UInventoryIconCache::RequestIcon(const TSoftObjectPtr<UTexture2D>& Icon, FOnInventoryIconLoaded OnLoaded)
+{
+	const FSoftObjectPath& Path = Icon.ToSoftObjectPath();
+
+	if (Path.IsNull())
+	{
+		return nullptr;
+	}
+
+	if (UTexture2D* const* Cached = m_Icons.Find(Path))
+	{
+		Touch(Path);
+		return *Cached;
+	}
+
+	// Already resident because something else is holding it
+	if (UTexture2D* const Loaded = Icon.Get())
+	{
+		m_Icons.Add(Path, Loaded);
+		Touch(Path);
+		Trim();
+
+		return Loaded;
+	}
+
+	TArray<FOnInventoryIconLoaded>* Pending = m_PendingLoads.Find(Path);
+	if (Pending == nullptr)
+	{
+		Pending = &m_PendingLoads.Add(Path);
+
+		UAssetManager::GetStreamableManager().RequestAsyncLoad(Path, FStreamableDelegate::CreateUObject(this, &UInventoryIconCache::OnIconLoaded, Path));
+	}
+
+	if (OnLoaded.IsBound())
+	{
+		Pending->Add(OnLoaded);
+	}
+
+	return m_Placeholder;
+}
+
+void UInventoryIconCache::OnIconLoaded(FSoftObjectPath Path)
+{
+	TArray<FOnInventoryIconLoaded> Callbacks;
+	m_PendingLoads.RemoveAndCopyValue(Path, Callbacks);
+
+	UTexture2D* const Icon = Cast<UTexture2D>(Path.ResolveObject());
+	if (Icon == nullptr)
+	{
+		LOG("Failed to load icon %s", *Path.ToString());
+		return;
+	}
+
+	m_Icons.Add(Path, Icon);
+	Touch(Path);
+	Trim();
+
+	for (FOnInventoryIconLoaded& Callback : Callbacks)
+	{
+		Callback.ExecuteIfBound(Icon);
+	}
+}
+
+void UInventoryIconCache::Touch(const FSoftObjectPath& Path)
+{
+	if (TDoubleLinkedList<FSoftObjectPath>::TDoubleLinkedListNode** Node = m_LRUNodes.Find(Path))
+	{
+		if (*Node == m_LRU.GetHead())
+		{
+			return;
+		}
+
+		m_LRU.RemoveNode(*Node);
+	}
+
+	m_LRU.AddHead(Path);
+	m_LRUNodes.Add(Path, m_LRU.GetHead());
+}
+
+void UInventoryIconCache::Trim()
+{
+	while (m_LRU.Num() > m_MaxIcons)
+	{
+		TDoubleLinkedList<FSoftObjectPath>::TDoubleLinkedListNode* const Tail = m_LRU.GetTail();
+		const FSoftObjectPath Path = Tail->GetValue();
+
+		m_LRUNodes.Remove(Path);
+		m_Icons.Remove(Path);
+		m_LRU.RemoveNode(Tail);
+	}
+}
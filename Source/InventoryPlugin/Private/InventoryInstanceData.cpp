@@ -0,0 +1,102 @@
+/**
+ * Copyright 2019-2020 - Russ 'trdwll' Treadwell https://trdwll.com
+ */
+
+
+#include "InventoryInstanceData.h"
+
+#include "InventoryComponent.h"
+
+void FInventoryInstanceData::PreReplicatedRemove(const FInventoryInstanceDataArray& InArraySerializer)
+{
+	InArraySerializer.bIndexDirty = true;
+
+	if (InArraySerializer.Owner)
+	{
+		InArraySerializer.Owner->OnInstanceDataChanged.Broadcast(InstanceID);
+	}
+}
+
+void FInventoryInstanceData::PostReplicatedAdd(const FInventoryInstanceDataArray& InArraySerializer)
+{
+	InArraySerializer.bIndexDirty = true;
+
+	if (InArraySerializer.Owner)
+	{
+		InArraySerializer.Owner->OnInstanceDataChanged.Broadcast(InstanceID);
+	}
+}
+
+void FInventoryInstanceData::PostReplicatedChange(const FInventoryInstanceDataArray& InArraySerializer)
+{
+	if (InArraySerializer.Owner)
+	{
+		InArraySerializer.Owner->OnInstanceDataChanged.Broadcast(InstanceID);
+	}
+}
+
+void FInventoryInstanceDataArray::RebuildIndex() const
+{
+	IndexByID.Reset();
+
+	for (int32 i = 0; i < Items.Num(); i++)
+	{
+		IndexByID.Add(Items[i].InstanceID, i);
+	}
+
+	bIndexDirty = false;
+}
+
+const FInventoryInstanceData* FInventoryInstanceDataArray::Find(int32 InstanceID) const
+{
+	if (InstanceID == 0)
+	{
+		return nullptr;
+	}
+
+	if (bIndexDirty)
+	{
+		RebuildIndex();
+	}
+
+	const int32* const Index = IndexByID.Find(InstanceID);
+	return Index && Items.IsValidIndex(*Index) && Items[*Index].InstanceID == InstanceID ? &Items[*Index] : nullptr;
+}
+
+FInventoryInstanceData& FInventoryInstanceDataArray::FindOrAdd(int32 InstanceID)
+{
+	if (FInventoryInstanceData* const Existing = Find(InstanceID))
+	{
+		return *Existing;
+	}
+
+	const int32 Index = Items.Emplace(InstanceID);
+	IndexByID.Add(InstanceID, Index);
+
+	MarkItemDirty(Items[Index]);
+	return Items[Index];
+}
+
+void FInventoryInstanceDataArray::Remove(int32 InstanceID)
+{
+	if (bIndexDirty)
+	{
+		RebuildIndex();
+	}
+
+	int32 Index = INDEX_NONE;
+	if (!IndexByID.RemoveAndCopyValue(InstanceID, Index))
+	{
+		return;
+	}
+
+	Items.RemoveAtSwap(Index);
+
+	// The last item moved into the hole
+	if (Items.IsValidIndex(Index))
+	{
+		IndexByID.Add(Items[Index].InstanceID, Index);
+	}
+
+	MarkArrayDirty();
+}
@@ -0,0 +1,428 @@
+/**
+ * Copyright 2019-2020 - Russ 'trdwll' Treadwell https://trdwll.com
+ */
+
+
+#include "InventoryItemDatabase.h"
+
+#include "InventoryBaseItem.h"
+#include "InventoryPluginSettings.h"
+
+#include "Algo/BinarySearch.h"
+#include "Engine/DataTable.h"
+#include "Engine/Texture2D.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Async/MappedFileHandle.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+static const uint32 DatabaseMagic = 0x42444E49; // "INDB"
+static const uint32 DatabaseVersion = 1;
+
+struct FInventoryItemDatabase::FStringRef
+{
+	uint32 Offset;
+	uint32 Length;
+};
+
+struct FInventoryItemDatabase::FHeader
+{
+	uint32 Magic;
+	uint32 Version;
+	uint32 ItemCount;
+	uint32 RecordsOffset;
+	uint32 IndexOffset;
+	uint32 StringsOffset;
+	uint32 StringsSize;
+	uint32 Reserved;
+};
+
+struct FInventoryItemDatabase::FIndexEntry
+{
+	uint32 Hash;
+	uint32 Record;
+};
+
+enum EItemRecordFlags : uint32
+{
+	IRF_AutoStack = 1 << 0,
+	IRF_ForceIntoActionBar = 1 << 1,
+	IRF_CanGoIntoActionBar = 1 << 2,
+	IRF_CanRotate = 1 << 3
+};
+
+struct FInventoryItemDatabase::FRecord
+{
+	FStringRef ID;
+	FStringRef Title;
+	FStringRef PluralTitle;
+	FStringRef Description;
+	FStringRef ExpiredItemRowName;
+	FStringRef CooldownGroup;
+	FStringRef Icon;
+	FStringRef ObjectClass;
+
+	int32 MaxStackSize;
+	float Weight;
+	float ConditionLifetime;
+	float ConditionLossPerUse;
+	float Cooldown;
+	float CastTime;
+	int32 FootprintX;
+	int32 FootprintY;
+	int32 BagSlots;
+	uint32 ItemAction;
+	uint32 Flags;
+};
+
+FInventoryItemDatabase::FInventoryItemDatabase() : m_Data(nullptr), m_Size(0)
+{
+}
+
+FInventoryItemDatabase::~FInventoryItemDatabase()
+{
+	Unload();
+}
+
+FString FInventoryItemDatabase::GetDatabaseFilename()
+{
+	const UInventoryPluginSettings* const Settings = GetDefault<UInventoryPluginSettings>();
+	return Settings && !Settings->m_ItemDatabaseFile.IsEmpty() ? FPaths::ProjectContentDir() / Settings->m_ItemDatabaseFile : FString();
+}
+
+bool FInventoryItemDatabase::Load(const FString& Filename)
+{
+	Unload();
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+	m_MappedFile.Reset(PlatformFile.OpenMapped(*Filename));
+	m_MappedRegion.Reset(m_MappedFile ? m_MappedFile->MapRegion() : nullptr);
+
+	if (m_MappedRegion)
+	{
+		m_Data = m_MappedRegion->GetMappedPtr();
+		m_Size = m_MappedRegion->GetMappedSize();
+	}
+	else
+	{
+		m_MappedFile.Reset();
+
+		if (!FFileHelper::LoadFileToArray(m_LoadedData, *Filename, FILEREAD_Silent))
+		{
+			return false;
+		}
+
+		m_Data = m_LoadedData.GetData();
+		m_Size = m_LoadedData.Num();
+	}
+
+	if (!Validate())
+	{
+		LOG("%s isn't an item database this version can read", *Filename);
+		Unload();
+		return false;
+	}
+
+	m_Items.Reserve(Num());
+
+	return true;
+}
+
+void FInventoryItemDatabase::Unload()
+{
+	m_Items.Empty();
+
+	m_MappedRegion.Reset();
+	m_MappedFile.Reset();
+	m_LoadedData.Empty();
+
+	m_Data = nullptr;
+	m_Size = 0;
+}
+
+bool FInventoryItemDatabase::Validate() const
+{
+	if (m_Data == nullptr || m_Size < (int64)sizeof(FHeader) || !IsAligned(m_Data, alignof(FHeader)))
+	{
+		return false;
+	}
+
+	const FHeader& Header = GetHeader();
+
+	if (Header.Magic != DatabaseMagic || Header.Version != DatabaseVersion)
+	{
+		return false;
+	}
+
+	const int64 RecordsEnd = (int64)Header.RecordsOffset + (int64)Header.ItemCount * sizeof(FRecord);
+	const int64 IndexEnd = (int64)Header.IndexOffset + (int64)Header.ItemCount * sizeof(FIndexEntry);
+	const int64 StringsEnd = (int64)Header.StringsOffset + Header.StringsSize;
+
+	if (RecordsEnd > m_Size || IndexEnd > m_Size || StringsEnd > m_Size || Header.RecordsOffset % 4 != 0 || Header.IndexOffset % 4 != 0)
+	{
+		return false;
+	}
+
+	// Checked once here so reading the records never has to
+	const FRecord* const Records = reinterpret_cast<const FRecord*>(m_Data + Header.RecordsOffset);
+	const FIndexEntry* const Index = reinterpret_cast<const FIndexEntry*>(m_Data + Header.IndexOffset);
+
+	for (uint32 i = 0; i < Header.ItemCount; i++)
+	{
+		if (Index[i].Record >= Header.ItemCount)
+		{
+			return false;
+		}
+
+		for (FStringRef FRecord::* String : { &FRecord::ID, &FRecord::Title, &FRecord::PluralTitle, &FRecord::Description, &FRecord::ExpiredItemRowName, &FRecord::CooldownGroup, &FRecord::Icon, &FRecord::ObjectClass })
+		{
+			if ((int64)(Records[i].*String).Offset + (Records[i].*String).Length > Header.StringsSize)
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+const FInventoryItemDatabase::FHeader& FInventoryItemDatabase::GetHeader() const
+{
+	return *reinterpret_cast<const FHeader*>(m_Data);
+}
+
+int32 FInventoryItemDatabase::Num() const
+{
+	return IsLoaded() ? (int32)GetHeader().ItemCount : 0;
+}
+
+uint32 FInventoryItemDatabase::HashID(const FString& ID)
+{
+	// Row names compare without case like FNames do
+	return FCrc::StrCrc32(*ID.ToLower());
+}
+
+FString FInventoryItemDatabase::GetString(const FStringRef& String) const
+{
+	if (String.Length == 0)
+	{
+		return FString();
+	}
+
+	const FUTF8ToTCHAR Converted(reinterpret_cast<const ANSICHAR*>(m_Data + GetHeader().StringsOffset + String.Offset), String.Length);
+	return FString(Converted.Length(), Converted.Get());
+}
+
+const FInventoryItemDatabase::FRecord* FInventoryItemDatabase::FindRecord(const FName& ID) const
+{
+	if (!IsLoaded() || ID.IsNone())
+	{
+		return nullptr;
+	}
+
+	const FHeader& Header = GetHeader();
+	const FRecord* const Records = reinterpret_cast<const FRecord*>(m_Data + Header.RecordsOffset);
+	const FIndexEntry* const Index = reinterpret_cast<const FIndexEntry*>(m_Data + Header.IndexOffset);
+
+	const FString IDString = ID.ToString();
+	const uint32 Hash = HashID(IDString);
+
+	// The first entry with the hash, then every entry that shares it
+	const int32 First = Algo::LowerBoundBy(TArrayView<const FIndexEntry>(Index, Header.ItemCount), Hash, [](const FIndexEntry& Entry) { return Entry.Hash; });
+
+	for (int32 i = First; i < (int32)Header.ItemCount && Index[i].Hash == Hash; i++)
+	{
+		const FRecord& Record = Records[Index[i].Record];
+		if (GetString(Record.ID).Equals(IDString, ESearchCase::IgnoreCase))
+		{
+			return &Record;
+		}
+	}
+
+	return nullptr;
+}
+
+const FInventoryItem* FInventoryItemDatabase::FindItem(const FName& ID)
+{
+	if (const FInventoryItem* const Item = m_Items.Find(ID))
+	{
+		return Item;
+	}
+
+	const FRecord* const Record = FindRecord(ID);
+	if (Record == nullptr)
+	{
+		return nullptr;
+	}
+
+	FInventoryItem& Item = m_Items.Add(ID);
+
+	Item.ID = ID;
+	Item.Title = GetString(Record->Title);
+	Item.PluralTitle = GetString(Record->PluralTitle);
+	Item.Description = GetString(Record->Description);
+	Item.ExpiredItemRowName = Record->ExpiredItemRowName.Length > 0 ? FName(*GetString(Record->ExpiredItemRowName)) : NAME_None;
+	Item.CooldownGroup = Record->CooldownGroup.Length > 0 ? FName(*GetString(Record->CooldownGroup)) : NAME_None;
+	Item.Icon = TSoftObjectPtr<UTexture2D>(FSoftObjectPath(GetString(Record->Icon)));
+	Item.ObjectClass = TSoftClassPtr<AInventoryBaseItem>(FSoftObjectPath(GetString(Record->ObjectClass)));
+
+	Item.MaxStackSize = Record->MaxStackSize;
+	Item.Weight = Record->Weight;
+	Item.ConditionLifetime = Record->ConditionLifetime;
+	Item.ConditionLossPerUse = Record->ConditionLossPerUse;
+	Item.Cooldown = Record->Cooldown;
+	Item.CastTime = Record->CastTime;
+	Item.Footprint = FIntPoint(Record->FootprintX, Record->FootprintY);
+	Item.BagSlots = Record->BagSlots;
+	Item.ItemAction = (EInventoryItemAction)Record->ItemAction;
+
+	Item.bAutoStack = (Record->Flags & IRF_AutoStack) != 0;
+	Item.bForceIntoActionBar = (Record->Flags & IRF_ForceIntoActionBar) != 0;
+	Item.bCanGoIntoActionBar = (Record->Flags & IRF_CanGoIntoActionBar) != 0;
+	Item.bCanRotate = (Record->Flags & IRF_CanRotate) != 0;
+
+	return &Item;
+}
+
+void FInventoryItemDatabase::ForEachItemText(TFunctionRef<void(const FName& ID, const FString& Title, const FString& PluralTitle, const FString& Description)> Callback) const
+{
+	if (!IsLoaded())
+	{
+		return;
+	}
+
+	const FHeader& Header = GetHeader();
+	const FRecord* const Records = reinterpret_cast<const FRecord*>(m_Data + Header.RecordsOffset);
+
+	for (uint32 i = 0; i < Header.ItemCount; i++)
+	{
+		Callback(FName(*GetString(Records[i].ID)), GetString(Records[i].Title), GetString(Records[i].PluralTitle), GetString(Records[i].Description));
+	}
+}
+
+uint32 FInventoryItemDatabase::HashRecord(const FRecord& Record) const
+{
+	// The fields after the strings are plain numbers and the strings are hashed from the pool
+	const SIZE_T NumbersOffset = STRUCT_OFFSET(FRecord, MaxStackSize);
+	uint32 Hash = FCrc::MemCrc32(reinterpret_cast<const uint8*>(&Record) + NumbersOffset, sizeof(FRecord) - NumbersOffset);
+
+	const uint8* const Strings = m_Data + GetHeader().StringsOffset;
+
+	for (FStringRef FRecord::* String : { &FRecord::Title, &FRecord::PluralTitle, &FRecord::Description, &FRecord::ExpiredItemRowName, &FRecord::CooldownGroup, &FRecord::Icon, &FRecord::ObjectClass })
+	{
+		Hash = FCrc::MemCrc32(Strings + (Record.*String).Offset, (Record.*String).Length, Hash);
+
+		// So moving text from one string to the next still changes the hash
+		Hash = FCrc::MemCrc32(&(Record.*String).Length, sizeof(uint32), Hash);
+	}
+
+	return Hash;
+}
+
+bool FInventoryItemDatabase::GetItemHash(const FName& ID, uint32& OutHash) const
+{
+	const FRecord* const Record = FindRecord(ID);
+	if (Record == nullptr)
+	{
+		return false;
+	}
+
+	OutHash = HashRecord(*Record);
+	return true;
+}
+
+void FInventoryItemDatabase::ForEachItemHash(TFunctionRef<void(const FName& ID, uint32 Hash)> Callback) const
+{
+	if (!IsLoaded())
+	{
+		return;
+	}
+
+	const FHeader& Header = GetHeader();
+	const FRecord* const Records = reinterpret_cast<const FRecord*>(m_Data + Header.RecordsOffset);
+
+	for (uint32 i = 0; i < Header.ItemCount; i++)
+	{
+		Callback(FName(*GetString(Records[i].ID)), HashRecord(Records[i]));
+	}
+}
+
+bool FInventoryItemDatabase::Write(const UDataTable& Table, TArray<uint8>& OutBlob)
+{
+	if (Table.GetRowStruct() == nullptr || !Table.GetRowStruct()->IsChildOf(FInventoryItem::StaticStruct()))
+	{
+		return false;
+	}
+
+	TArray<FRecord> Records;
+	TArray<FIndexEntry> Index;
+	TArray<uint8> Strings;
+
+	auto AddString = [&Strings](const FString& String)
+	{
+		FStringRef Ref;
+		Ref.Offset = Strings.Num();
+
+		const FTCHARToUTF8 UTF8(*String);
+		Strings.Append(reinterpret_cast<const uint8*>(UTF8.Get()), UTF8.Length());
+
+		Ref.Length = UTF8.Length();
+		return Ref;
+	};
+
+	for (const TPair<FName, uint8*>& Row : Table.GetRowMap())
+	{
+		const FInventoryItem& Item = *reinterpret_cast<const FInventoryItem*>(Row.Value);
+		const FString ID = Row.Key.ToString();
+
+		FRecord Record;
+		FMemory::Memzero(Record);
+
+		Record.ID = AddString(ID);
+		Record.Title = AddString(Item.Title);
+		Record.PluralTitle = AddString(Item.PluralTitle);
+		Record.Description = AddString(Item.Description);
+		Record.ExpiredItemRowName = AddString(Item.ExpiredItemRowName.IsNone() ? FString() : Item.ExpiredItemRowName.ToString());
+		Record.CooldownGroup = AddString(Item.CooldownGroup.IsNone() ? FString() : Item.CooldownGroup.ToString());
+		Record.Icon = AddString(Item.Icon.ToSoftObjectPath().ToString());
+		Record.ObjectClass = AddString(Item.ObjectClass.ToSoftObjectPath().ToString());
+
+		Record.MaxStackSize = Item.MaxStackSize;
+		Record.Weight = Item.Weight;
+		Record.ConditionLifetime = Item.ConditionLifetime;
+		Record.ConditionLossPerUse = Item.ConditionLossPerUse;
+		Record.Cooldown = Item.Cooldown;
+		Record.CastTime = Item.CastTime;
+		Record.FootprintX = Item.Footprint.X;
+		Record.FootprintY = Item.Footprint.Y;
+		Record.BagSlots = Item.BagSlots;
+		Record.ItemAction = (uint32)Item.ItemAction;
+		Record.Flags = (Item.bAutoStack ? IRF_AutoStack : 0) | (Item.bForceIntoActionBar ? IRF_ForceIntoActionBar : 0) | (Item.bCanGoIntoActionBar ? IRF_CanGoIntoActionBar : 0) | (Item.bCanRotate ? IRF_CanRotate : 0);
+
+		FIndexEntry Entry;
+		Entry.Hash = HashID(ID);
+		Entry.Record = Records.Add(Record);
+		Index.Add(Entry);
+	}
+
+	Index.Sort([](const FIndexEntry& A, const FIndexEntry& B) { return A.Hash < B.Hash; });
+
+	FHeader Header;
+	FMemory::Memzero(Header);
+	Header.Magic = DatabaseMagic;
+	Header.Version = DatabaseVersion;
+	Header.ItemCount = Records.Num();
+	Header.RecordsOffset = sizeof(FHeader);
+	Header.IndexOffset = Header.RecordsOffset + Records.Num() * sizeof(FRecord);
+	Header.StringsOffset = Header.IndexOffset + Index.Num() * sizeof(FIndexEntry);
+	Header.StringsSize = Strings.Num();
+
+	OutBlob.Reset(Header.StringsOffset + Strings.Num());
+	OutBlob.Append(reinterpret_cast<const uint8*>(&Header), sizeof(FHeader));
+	OutBlob.Append(reinterpret_cast<const uint8*>(Records.GetData()), Records.Num() * sizeof(FRecord));
+	OutBlob.Append(reinterpret_cast<const uint8*>(Index.GetData()), Index.Num() * sizeof(FIndexEntry));
+	OutBlob.Append(Strings);
+
+	return true;
+}
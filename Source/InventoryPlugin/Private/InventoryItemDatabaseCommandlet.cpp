@@ -0,0 +1,55 @@
+/**
+ * Copyright 2019-2020 - Russ 'trdwll' Treadwell https://trdwll.com
+ */
+
+
+#include "InventoryItemDatabaseCommandlet.h"
+
+#include "InventoryItemDatabase.h"
+#include "InventoryPluginSettings.h"
+#include "InventorySystem.h"
+
+#include "Engine/DataTable.h"
+#include "Misc/FileHelper.h"
+
+UInventoryItemDatabaseCommandlet::UInventoryItemDatabaseCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UInventoryItemDatabaseCommandlet::Main(const FString& Params)
+{
+	const UInventoryPluginSettings* const Settings = GetDefault<UInventoryPluginSettings>();
+	UDataTable* const DataTable = Settings ? Cast<UDataTable>(Settings->m_ActorGroupDataTable.TryLoad()) : nullptr;
+
+	if (DataTable == nullptr)
+	{
+		LOG("The item DataTable isn't set in the plugin settings");
+		return 1;
+	}
+
+	FString Filename;
+	if (!FParse::Value(*Params, TEXT("Output="), Filename))
+	{
+		Filename = FInventoryItemDatabase::GetDatabaseFilename();
+	}
+
+	TArray<uint8> Blob;
+	if (Filename.IsEmpty() || !FInventoryItemDatabase::Write(*DataTable, Blob))
+	{
+		LOG("Couldn't bake %s, the DataTable has to hold FInventoryItem rows and Item Database File has to be set", *DataTable->GetPathName());
+		return 1;
+	}
+
+	if (!FFileHelper::SaveArrayToFile(Blob, *Filename))
+	{
+		LOG("Couldn't write %s", *Filename);
+		return 1;
+	}
+
+	LOG("Baked %d items into %s (%d bytes)", DataTable->GetRowMap().Num(), *Filename, Blob.Num());
+	return 0;
+}
@@ -0,0 +1,466 @@
+/**
+ * Copyright 2019-2020 - Russ 'trdwll' Treadwell https://trdwll.com
+ */
+
+
+#include "InventoryItemSubsystem.h"
+
+#include "InventoryPluginSettings.h"
+#include "InventorySubsystem.h"
+
+#include "Engine/DataTable.h"
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+static FAutoConsoleCommandWithWorld ReloadItemsCommand(
+	TEXT("Inventory.ReloadItems"),
+	TEXT("Reload the item definitions and send the ones that changed to every client."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		UInventoryItemSubsystem* const Subsystem = World && World->GetGameInstance() ? World->GetGameInstance()->GetSubsystem<UInventoryItemSubsystem>() : nullptr;
+
+		if (Subsystem)
+		{
+			Subsystem->ReloadItems();
+		}
+	}));
+
+void UInventoryItemSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	m_DataTable = nullptr;
+	m_RegistryVersion = 0;
+	m_bRequestedDefinitions = false;
+
+	// The definitions a server sends only hold for as long as we're connected to it
+	FWorldDelegates::OnPostWorldInitialization.AddUObject(this, &UInventoryItemSubsystem::OnPostWorldInitialization);
+
+	if (GEngine)
+	{
+		GEngine->OnNetworkFailure().AddUObject(this, &UInventoryItemSubsystem::OnNetworkFailure);
+		GEngine->OnTravelFailure().AddUObject(this, &UInventoryItemSubsystem::OnTravelFailure);
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	const FString Filename = FInventoryItemDatabase::GetDatabaseFilename();
+	m_Database = MakeUnique<FInventoryItemDatabase>();
+
+	if (!GIsEditor && !Filename.IsEmpty() && m_Database->Load(Filename))
+	{
+		LOG("Mapped %d items from %s in %.2f ms", m_Database->Num(), *Filename, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+		BuildSearchIndex();
+		return;
+	}
+
+	const UInventoryPluginSettings* const Settings = GetDefault<UInventoryPluginSettings>();
+	m_DataTable = Settings ? Cast<UDataTable>(Settings->m_ActorGroupDataTable.TryLoad()) : nullptr;
+
+	if (m_DataTable)
+	{
+		CopyRows();
+		HashRows(m_RowHashes);
+
+		LOG("Loaded %d items from the DataTable in %.2f ms", m_TableItems.Num(), (FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+		// Rows edited in the editor go out like a reload
+		m_DataTable->OnDataTableChanged().AddWeakLambda(this, [this]()
+		{
+			ReloadItems();
+		});
+	}
+
+	BuildSearchIndex();
+}
+
+void UInventoryItemSubsystem::BuildSearchIndex()
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	m_SearchIndex.Reset();
+
+	// The definitions from the server first, the index keeps the first text it's given for an item
+	for (const TPair<FName, FInventoryItem>& Received : m_ReceivedItems)
+	{
+		m_SearchIndex.AddItem(Received.Key, Received.Value.Title, Received.Value.PluralTitle, Received.Value.Description);
+	}
+
+	if (IsUsingItemDatabase())
+	{
+		m_Database->ForEachItemText([this](const FName& ID, const FString& Title, const FString& PluralTitle, const FString& Description)
+		{
+			if (!m_RemovedItems.Contains(ID))
+			{
+				m_SearchIndex.AddItem(ID, Title, PluralTitle, Description);
+			}
+		});
+	}
+	else if (m_DataTable && m_DataTable->GetRowStruct() && m_DataTable->GetRowStruct()->IsChildOf(FInventoryItem::StaticStruct()))
+	{
+		for (const TPair<FName, uint8*>& Row : m_DataTable->GetRowMap())
+		{
+			if (!m_RemovedItems.Contains(Row.Key))
+			{
+				const FInventoryItem* const Item = reinterpret_cast<const FInventoryItem*>(Row.Value);
+				m_SearchIndex.AddItem(Row.Key, Item->Title, Item->PluralTitle, Item->Description);
+			}
+		}
+	}
+
+	m_SearchIndex.Finalize();
+
+	LOG("Indexed the text of %d items in %.2f ms", m_SearchIndex.Num(), (FPlatformTime::Seconds() - StartTime) * 1000.0);
+}
+
+void UInventoryItemSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnPostWorldInitialization.RemoveAll(this);
+
+	if (GEngine)
+	{
+		GEngine->OnNetworkFailure().RemoveAll(this);
+		GEngine->OnTravelFailure().RemoveAll(this);
+	}
+
+	if (m_DataTable)
+	{
+		m_DataTable->OnDataTableChanged().RemoveAll(this);
+	}
+
+	m_Database.Reset();
+	m_DataTable = nullptr;
+	m_TableItems.Empty();
+	m_SearchIndex.Reset();
+	m_ReceivedItems.Empty();
+	m_RemovedItems.Empty();
+	m_ChangedItems.Empty();
+	m_RowHashes.Empty();
+
+	Super::Deinitialize();
+}
+
+const FInventoryItem* UInventoryItemSubsystem::FindItem(const FName& ID)
+{
+	if (m_RemovedItems.Num() > 0 && m_RemovedItems.Contains(ID))
+	{
+		return nullptr;
+	}
+
+	if (m_ReceivedItems.Num() > 0)
+	{
+		if (const FInventoryItem* const Received = m_ReceivedItems.Find(ID))
+		{
+			return Received;
+		}
+	}
+
+	if (IsUsingItemDatabase())
+	{
+		return m_Database->FindItem(ID);
+	}
+
+	return m_TableItems.Find(ID);
+}
+
+void UInventoryItemSubsystem::CopyRows()
+{
+	m_TableItems.Reset();
+
+	if (m_DataTable == nullptr || m_DataTable->GetRowStruct() == nullptr || !m_DataTable->GetRowStruct()->IsChildOf(FInventoryItem::StaticStruct()))
+	{
+		return;
+	}
+
+	m_TableItems.Reserve(m_DataTable->GetRowMap().Num());
+
+	for (const TPair<FName, uint8*>& Row : m_DataTable->GetRowMap())
+	{
+		FInventoryItem& Item = m_TableItems.Add(Row.Key, *reinterpret_cast<const FInventoryItem*>(Row.Value));
+		Item.ID = Row.Key;
+	}
+}
+
+void UInventoryItemSubsystem::HashRows(TMap<FName, uint32>& OutHashes) const
+{
+	OutHashes.Reset();
+
+	if (m_DataTable == nullptr || m_DataTable->GetRowStruct() == nullptr || !m_DataTable->GetRowStruct()->IsChildOf(FInventoryItem::StaticStruct()))
+	{
+		return;
+	}
+
+	OutHashes.Reserve(m_DataTable->GetRowMap().Num());
+
+	FString Text;
+
+	for (const TPair<FName, uint8*>& Row : m_DataTable->GetRowMap())
+	{
+		// Only set on the copies, and it's the row name rather than part of the definition
+		FInventoryItem Item = *reinterpret_cast<const FInventoryItem*>(Row.Value);
+		Item.ID = NAME_None;
+
+		Text.Reset();
+		FInventoryItem::StaticStruct()->ExportText(Text, &Item, nullptr, nullptr, PPF_None, nullptr);
+
+		OutHashes.Add(Row.Key, FCrc::StrCrc32(*Text));
+	}
+}
+
+int32 UInventoryItemSubsystem::ReloadItems()
+{
+	const UWorld* const World = GetGameInstance() ? GetGameInstance()->GetWorld() : nullptr;
+	if (World && World->GetNetMode() == NM_Client)
+	{
+		LOG("Items can only be reloaded on the server");
+		return 0;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	TSet<FName> Changed;
+
+	if (IsUsingItemDatabase())
+	{
+		TUniquePtr<FInventoryItemDatabase> Reloaded = MakeUnique<FInventoryItemDatabase>();
+
+		if (!Reloaded->Load(FInventoryItemDatabase::GetDatabaseFilename()))
+		{
+			LOG("Couldn't reload the item database, keeping the items that are loaded");
+			return 0;
+		}
+
+		// Compared in the blobs so nothing has to be looked up
+		Reloaded->ForEachItemHash([this, &Changed](const FName& ID, uint32 Hash)
+		{
+			uint32 OldHash = 0;
+			if (!m_Database->GetItemHash(ID, OldHash) || OldHash != Hash)
+			{
+				Changed.Add(ID);
+			}
+		});
+
+		// Items that aren't in the new database at all
+		m_Database->ForEachItemHash([&Reloaded, &Changed](const FName& ID, uint32 Hash)
+		{
+			uint32 NewHash = 0;
+			if (!Reloaded->GetItemHash(ID, NewHash))
+			{
+				Changed.Add(ID);
+			}
+		});
+
+		m_Database = MoveTemp(Reloaded);
+	}
+	else if (m_DataTable)
+	{
+		CopyRows();
+
+		TMap<FName, uint32> Hashes;
+		HashRows(Hashes);
+
+		for (const TPair<FName, uint32>& Hash : Hashes)
+		{
+			const uint32* const OldHash = m_RowHashes.Find(Hash.Key);
+			if (OldHash == nullptr || *OldHash != Hash.Value)
+			{
+				Changed.Add(Hash.Key);
+			}
+		}
+
+		// Rows that were deleted
+		for (const TPair<FName, uint32>& OldHash : m_RowHashes)
+		{
+			if (!Hashes.Contains(OldHash.Key))
+			{
+				Changed.Add(OldHash.Key);
+			}
+		}
+
+		m_RowHashes = MoveTemp(Hashes);
+	}
+
+	if (Changed.Num() == 0)
+	{
+		return 0;
+	}
+
+	m_ChangedItems.Append(Changed);
+	CommitChanges(Changed);
+
+	// Only what changed goes to the clients, the slots holding it aren't touched
+	TArray<FInventoryItem> Definitions;
+	TArray<FName> RemovedItems;
+	Definitions.Reserve(Changed.Num());
+
+	for (const FName& ID : Changed)
+	{
+		if (const FInventoryItem* const Item = FindItem(ID))
+		{
+			Definitions.Add(*Item);
+		}
+		else
+		{
+			RemovedItems.Add(ID);
+		}
+	}
+
+	if (RemovedItems.Num() > 0)
+	{
+		LOG("%d items were removed, the stacks holding them keep their last definition", RemovedItems.Num());
+	}
+
+	if (UInventorySubsystem* const Subsystem = World ? World->GetSubsystem<UInventorySubsystem>() : nullptr)
+	{
+		Subsystem->SendItemDefinitions(m_RegistryVersion, Definitions, RemovedItems);
+	}
+
+	LOG("Reloaded %d changed items in %.2f ms (registry version %d)", Changed.Num(), (FPlatformTime::Seconds() - StartTime) * 1000.0, m_RegistryVersion);
+
+	return Changed.Num();
+}
+
+void UInventoryItemSubsystem::ApplyDefinitions(int32 Version, const TArray<FInventoryItem>& Items, const TArray<FName>& RemovedItems)
+{
+	// Large reloads come in a few parts with the same version
+	if (Version < m_RegistryVersion)
+	{
+		return;
+	}
+
+	TMap<FName, FInventoryItem> Received = m_ReceivedItems;
+	TSet<FName> Changed;
+
+	for (const FInventoryItem& Item : Items)
+	{
+		if (!Item.ID.IsNone())
+		{
+			Received.Add(Item.ID, Item);
+			m_RemovedItems.Remove(Item.ID);
+			Changed.Add(Item.ID);
+		}
+	}
+
+	for (const FName& ID : RemovedItems)
+	{
+		Received.Remove(ID);
+		m_RemovedItems.Add(ID);
+		Changed.Add(ID);
+	}
+
+	m_ReceivedItems = MoveTemp(Received);
+	m_RegistryVersion = Version - 1;
+
+	CommitChanges(Changed);
+}
+
+void UInventoryItemSubsystem::CommitChanges(const TSet<FName>& Changed)
+{
+	m_RegistryVersion++;
+
+	BuildSearchIndex();
+
+	OnItemDefinitionsChanged.Broadcast(Changed);
+}
+
+void UInventoryItemSubsystem::GetChangedDefinitions(TArray<FInventoryItem>& OutItems, TArray<FName>& OutRemovedItems)
+{
+	OutItems.Reset(m_ChangedItems.Num());
+	OutRemovedItems.Reset();
+
+	for (const FName& ID : m_ChangedItems)
+	{
+		if (const FInventoryItem* const Item = FindItem(ID))
+		{
+			OutItems.Add(*Item);
+		}
+		else
+		{
+			OutRemovedItems.Add(ID);
+		}
+	}
+}
+
+void UInventoryItemSubsystem::ResetReceivedDefinitions()
+{
+	// Only clients ask for or receive definitions, the server keeps its version for the clients that join later
+	if (!m_bRequestedDefinitions && m_ReceivedItems.Num() == 0 && m_RemovedItems.Num() == 0)
+	{
+		return;
+	}
+
+	m_bRequestedDefinitions = false;
+	m_RegistryVersion = 0;
+
+	if (m_ReceivedItems.Num() == 0 && m_RemovedItems.Num() == 0)
+	{
+		return;
+	}
+
+	TSet<FName> Changed = MoveTemp(m_RemovedItems);
+	m_RemovedItems.Reset();
+	Changed.Reserve(Changed.Num() + m_ReceivedItems.Num());
+
+	for (const TPair<FName, FInventoryItem>& Received : m_ReceivedItems)
+	{
+		Changed.Add(Received.Key);
+	}
+
+	m_ReceivedItems.Empty();
+
+	LOG("Dropped %d item definitions from the last server", Changed.Num());
+
+	BuildSearchIndex();
+
+	OnItemDefinitionsChanged.Broadcast(Changed);
+}
+
+void UInventoryItemSubsystem::OnPostWorldInitialization(UWorld* World, const UWorld::InitializationValues IVS)
+{
+	// Every game instance's worlds come through here, in PIE there's one per client
+	if (World && World->IsGameWorld() && World->GetGameInstance() == GetGameInstance())
+	{
+		ResetReceivedDefinitions();
+	}
+}
+
+void UInventoryItemSubsystem::OnNetworkFailure(UWorld* World, UNetDriver* NetDriver, ENetworkFailure::Type FailureType, const FString& ErrorString)
+{
+	if (World == nullptr || World->GetGameInstance() == GetGameInstance())
+	{
+		ResetReceivedDefinitions();
+	}
+}
+
+void UInventoryItemSubsystem::OnTravelFailure(UWorld* World, ETravelFailure::Type FailureType, const FString& ErrorString)
+{
+	if (World == nullptr || World->GetGameInstance() == GetGameInstance())
+	{
+		ResetReceivedDefinitions();
+	}
+}
+
+bool UInventoryItemSubsystem::ShouldRequestDefinitions()
+{
+	const bool bShouldRequest = !m_bRequestedDefinitions;
+	m_bRequestedDefinitions = true;
+	return bShouldRequest;
+}
+
+TArray<FName> UInventoryItemSubsystem::SearchItems(const FString& Text) const
+{
+	TArray<FName> Items;
+
+	TBitArray<> Matches;
+	if (m_SearchIndex.Search(Text, Matches))
+	{
+		for (TConstSetBitIterator<> It(Matches); It; ++It)
+		{
+			Items.Add(m_SearchIndex.GetItemID(It.GetIndex()));
+		}
+	}
+
+	return Items;
+}
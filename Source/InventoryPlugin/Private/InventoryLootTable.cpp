@@ -0,0 +1,216 @@
+/**
+ * Copyright 2019-2020 - Russ 'trdwll' Treadwell https://trdwll.com
+ */
+
+
+#include "InventoryLootTable.h"
+
+UInventoryLootTable::UInventoryLootTable()
+{
+	m_MinRolls = 1;
+	m_MaxRolls = 1;
+}
+
+void UInventoryLootTable::PostLoad()
+{
+	Super::PostLoad();
+
+	Compile();
+}
+
+#if WITH_EDITOR
+void UInventoryLootTable::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	Compile();
+}
+#endif
+
+void UInventoryLootTable::RemoveCycles()
+{
+	for (FLootTableEntry& Entry : m_Entries)
+	{
+		if (Entry.NestedTable == nullptr)
+		{
+			continue;
+		}
+
+		TSet<const UInventoryLootTable*> Visited;
+		if (Entry.NestedTable == this || Entry.NestedTable->ContainsTable(this, Visited))
+		{
+			LOG("Loot table %s contains itself through %s, the nested table was removed", *GetName(), *Entry.NestedTable->GetName());
+			Entry.NestedTable = nullptr;
+		}
+	}
+}
+
+bool UInventoryLootTable::ContainsTable(const UInventoryLootTable* Table, TSet<const UInventoryLootTable*>& Visited) const
+{
+	for (const FLootTableEntry& Entry : m_Entries)
+	{
+		if (Entry.NestedTable == nullptr)
+		{
+			continue;
+		}
+
+		if (Entry.NestedTable == Table)
+		{
+			return true;
+		}
+
+		bool bAlreadyVisited = false;
+		Visited.Add(Entry.NestedTable, &bAlreadyVisited);
+
+		if (!bAlreadyVisited && Entry.NestedTable->ContainsTable(Table, Visited))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void UInventoryLootTable::Compile()
+{
+	// The entry is left with its weight, so it becomes a chance of dropping nothing
+	RemoveCycles();
+
+	const int32 Count = m_Entries.Num();
+
+	m_Probability.Init(0.0f, Count);
+	m_Alias.Init(INDEX_NONE, Count);
+
+	double TotalWeight = 0.0;
+	for (const FLootTableEntry& Entry : m_Entries)
+	{
+		TotalWeight += FMath::Max(0.0f, Entry.Weight);
+	}
+
+	if (TotalWeight <= 0.0)
+	{
+		m_Probability.Empty();
+		m_Alias.Empty();
+		return;
+	}
+
+	// Scale the weights so the average is 1, then pair every entry under 1 with one over 1 to fill its column (Vose's method)
+	TArray<double> Scaled;
+	Scaled.SetNumUninitialized(Count);
+
+	TArray<int32> Small;
+	TArray<int32> Large;
+
+	for (int32 i = 0; i < Count; i++)
+	{
+		Scaled[i] = FMath::Max(0.0f, m_Entries[i].Weight) * Count / TotalWeight;
+		(Scaled[i] < 1.0 ? Small : Large).Add(i);
+	}
+
+	while (Small.Num() > 0 && Large.Num() > 0)
+	{
+		const int32 Less = Small.Pop(false);
+		const int32 More = Large.Pop(false);
+
+		m_Probability[Less] = Scaled[Less];
+		m_Alias[Less] = More;
+
+		Scaled[More] = (Scaled[More] + Scaled[Less]) - 1.0;
+		(Scaled[More] < 1.0 ? Small : Large).Add(More);
+	}
+
+	// Whatever is left is 1 give or take rounding
+	for (int32 Index : Large)
+	{
+		m_Probability[Index] = 1.0f;
+	}
+
+	for (int32 Index : Small)
+	{
+		m_Probability[Index] = 1.0f;
+	}
+}
+
+int32 UInventoryLootTable::PickEntry(FRandomStream& Stream) const
+{
+	const int32 Count = m_Probability.Num();
+	if (Count == 0)
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 Column = Stream.RandHelper(Count);
+	return Stream.GetFraction() < m_Probability[Column] ? Column : m_Alias[Column];
+}
+
+void UInventoryLootTable::Roll(FRandomStream& Stream, TArray<FInventoryItemMeta>& OutItems) const
+{
+	int32 WorkLeft = MaxRollWork;
+	RollInternal(Stream, OutItems, 0, WorkLeft);
+
+	if (WorkLeft <= 0)
+	{
+		LOG("Loot table %s stopped after %d picks and nested rolls, the nested quantities are too high", *GetName(), MaxRollWork);
+	}
+}
+
+void UInventoryLootTable::RollInternal(FRandomStream& Stream, TArray<FInventoryItemMeta>& OutItems, int32 Depth, int32& WorkLeft) const
+{
+	if (Depth > MaxNestingDepth)
+	{
+		LOG("Loot table %s is nested too deep", *GetName());
+		return;
+	}
+
+	if (--WorkLeft < 0)
+	{
+		return;
+	}
+
+	const int32 Rolls = Stream.RandRange(m_MinRolls, FMath::Max(m_MinRolls, m_MaxRolls));
+
+	for (int32 i = 0; i < Rolls && WorkLeft > 0; i++)
+	{
+		WorkLeft--;
+
+		const int32 Index = PickEntry(Stream);
+		if (Index == INDEX_NONE)
+		{
+			return;
+		}
+
+		const FLootTableEntry& Entry = m_Entries[Index];
+		const int32 Quantity = Stream.RandRange(Entry.MinQuantity, FMath::Max(Entry.MinQuantity, Entry.MaxQuantity));
+
+		if (Entry.NestedTable)
+		{
+			for (int32 j = 0; j < Quantity && WorkLeft > 0; j++)
+			{
+				Entry.NestedTable->RollInternal(Stream, OutItems, Depth + 1, WorkLeft);
+			}
+		}
+		else if (!Entry.ItemRowName.IsNone() && Quantity > 0)
+		{
+			OutItems.Emplace(Entry.ItemRowName, Quantity);
+		}
+	}
+}
+
+TArray<FInventoryItemMeta> UInventoryLootTable::RollLoot(int32 Seed) const
+{
+	FRandomStream Stream(Seed);
+
+	TArray<FInventoryItemMeta> Items;
+	Roll(Stream, Items);
+
+	return Items;
+}
+
+void UInventoryLootTable::SetEntries(const TArray<FLootTableEntry>& Entries, int32 MinRolls, int32 MaxRolls)
+{
+	m_Entries = Entries;
+	m_MinRolls = FMath::Max(0, MinRolls);
+	m_MaxRolls = FMath::Max(0, MaxRolls);
+
+	Compile();
+}
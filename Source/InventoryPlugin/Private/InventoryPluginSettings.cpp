@@ -5,4 +5,10 @@
 
 UInventoryPluginSettings::UInventoryPluginSettings()
 {
+	m_ItemDatabaseFile = TEXT("InventoryData/Items.indb");
+
+	m_IconCacheSize = 128;
+
+	m_OperationsPerSecond = 20.0f;
+	m_OperationBurst = 40.0f;
 }
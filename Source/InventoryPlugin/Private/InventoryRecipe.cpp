@@ -0,0 +1,21 @@
+/**
+ * Copyright 2019-2020 - Russ 'trdwll' Treadwell https://trdwll.com
+ */
+
+
+#include "InventoryRecipe.h"
+
+bool UInventoryRecipe::HasInputs(const TMap<FName, int32>& ItemTotals, int32 Count) const
+{
+	for (const FInventoryItemMeta& Input : m_Inputs)
+	{
+		const int32* const Total = ItemTotals.Find(Input.ItemRowName);
+		// In 64 bits so a large count can't wrap around
+		if (Total == nullptr || Input.Quantity < 0 || *Total < (int64)Input.Quantity * Count)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,126 @@
+/**
+ * Copyright 2019-2020 - Russ 'trdwll' Treadwell https://trdwll.com
+ */
+
+
+#include "InventorySearchIndex.h"
+
+#include "Algo/BinarySearch.h"
+
+void FInventorySearchIndex::Reset()
+{
+	m_ItemIDs.Reset();
+	m_ItemIndex.Reset();
+	m_Words.Reset();
+	m_Items.Reset();
+	m_PendingWords.Reset();
+}
+
+void FInventorySearchIndex::Tokenize(const FString& Text, TArray<FString, TInlineAllocator<16>>& OutWords)
+{
+	OutWords.Reset();
+
+	int32 Start = INDEX_NONE;
+
+	for (int32 i = 0; i <= Text.Len(); i++)
+	{
+		const bool bWordChar = i < Text.Len() && FChar::IsAlnum(Text[i]);
+
+		if (bWordChar && Start == INDEX_NONE)
+		{
+			Start = i;
+		}
+		else if (!bWordChar && Start != INDEX_NONE)
+		{
+			OutWords.Add(Text.Mid(Start, i - Start).ToLower());
+			Start = INDEX_NONE;
+		}
+	}
+}
+
+void FInventorySearchIndex::AddItem(const FName& ID, const FString& Title, const FString& PluralTitle, const FString& Description)
+{
+	if (ID.IsNone() || m_ItemIndex.Contains(ID))
+	{
+		return;
+	}
+
+	const int32 ItemIndex = m_ItemIDs.Add(ID);
+	m_ItemIndex.Add(ID, ItemIndex);
+
+	TArray<FString, TInlineAllocator<16>> Words;
+
+	for (const FString* Text : { &Title, &PluralTitle, &Description })
+	{
+		Tokenize(*Text, Words);
+
+		for (FString& Word : Words)
+		{
+			TArray<int32>& Items = m_PendingWords.FindOrAdd(MoveTemp(Word));
+
+			// Items are added in order so a repeated word is always the last one
+			if (Items.Num() == 0 || Items.Last() != ItemIndex)
+			{
+				Items.Add(ItemIndex);
+			}
+		}
+	}
+}
+
+void FInventorySearchIndex::Finalize()
+{
+	m_PendingWords.KeySort([](const FString& A, const FString& B) { return A.Compare(B, ESearchCase::CaseSensitive) < 0; });
+
+	m_Words.Reset(m_PendingWords.Num());
+	m_Items.Reset(m_PendingWords.Num());
+
+	for (TPair<FString, TArray<int32>>& Pair : m_PendingWords)
+	{
+		m_Words.Add(MoveTemp(Pair.Key));
+		m_Items.Add(MoveTemp(Pair.Value));
+	}
+
+	m_PendingWords.Empty();
+}
+
+bool FInventorySearchIndex::Search(const FString& Text, TBitArray<>& OutMatches) const
+{
+	TArray<FString, TInlineAllocator<16>> Terms;
+	Tokenize(Text, Terms);
+
+	if (Terms.Num() == 0)
+	{
+		return false;
+	}
+
+	TBitArray<> TermMatches;
+
+	for (const FString& Term : Terms)
+	{
+		TermMatches.Init(false, m_ItemIDs.Num());
+
+		// Every word starting with the term sorts right after it
+		const int32 First = Algo::LowerBound(m_Words, Term, [](const FString& A, const FString& B) { return A.Compare(B, ESearchCase::CaseSensitive) < 0; });
+
+		for (int32 i = First; i < m_Words.Num() && m_Words[i].StartsWith(Term, ESearchCase::CaseSensitive); i++)
+		{
+			for (int32 ItemIndex : m_Items[i])
+			{
+				TermMatches[ItemIndex] = true;
+			}
+		}
+
+		if (&Term == &Terms[0])
+		{
+			OutMatches = MoveTemp(TermMatches);
+			continue;
+		}
+
+		for (int32 i = 0; i < OutMatches.Num(); i++)
+		{
+			OutMatches[i] = OutMatches[i] && TermMatches[i];
+		}
+	}
+
+	return true;
+}
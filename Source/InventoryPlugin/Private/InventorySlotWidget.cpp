@@ -7,11 +7,119 @@
 
 #include "InventorySystem.h"
 #include "InventoryDragDropOperation.h"
+#include "InventoryIconCache.h"
 
 #include "Engine.h"
 
 #include "Blueprint/WidgetBlueprintLibrary.h"
 
+void UInventorySlotWidget::NativeConstruct()
+{
+	Super::NativeConstruct();
+
+	BindToInventory();
+	RefreshSlot(true);
+}
+
+void UInventorySlotWidget::NativeDestruct()
+{
+	UnbindFromInventory();
+
+	Super::NativeDestruct();
+}
+
+void UInventorySlotWidget::BindToInventory()
+{
+	if (m_BoundInventory == m_Inventory)
+	{
+		return;
+	}
+
+	UnbindFromInventory();
+
+	if (m_Inventory)
+	{
+		m_Inventory->OnSlotChanged.AddDynamic(this, &UInventorySlotWidget::HandleSlotChanged);
+		m_BoundInventory = m_Inventory;
+	}
+}
+
+void UInventorySlotWidget::UnbindFromInventory()
+{
+	if (m_BoundInventory)
+	{
+		m_BoundInventory->OnSlotChanged.RemoveDynamic(this, &UInventorySlotWidget::HandleSlotChanged);
+		m_BoundInventory = nullptr;
+	}
+}
+
+void UInventorySlotWidget::HandleSlotChanged(int32 SlotIndex)
+{
+	// Always rebuild, a predicted move changes what's shown without changing the replicated version
+	if (SlotIndex == m_SlotID)
+	{
+		RefreshSlot(true);
+	}
+}
+
+void UInventorySlotWidget::SetSlot(UInventoryComponent* Inventory, int32 SlotID)
+{
+	const bool bChanged = m_Inventory != Inventory || m_SlotID != SlotID;
+
+	m_Inventory = Inventory;
+	m_SlotID = SlotID;
+
+	BindToInventory();
+
+	RefreshSlot(bChanged);
+}
+
+void UInventorySlotWidget::RefreshSlot(bool bForce)
+{
+	const int32 Version = m_Inventory ? m_Inventory->GetSlotVersion(m_SlotID) : INDEX_NONE;
+
+	if (!bForce && Version == m_CachedVersion)
+	{
+		return;
+	}
+
+	m_CachedVersion = Version;
+	m_CachedItem = GetItemByIndex();
+
+	OnSlotRefreshed(m_CachedItem);
+	UpdateIcon();
+}
+
+void UInventorySlotWidget::UpdateIcon()
+{
+	UTexture2D* NewIcon = nullptr;
+
+	UInventoryIconCache* const IconCache = GetGameInstance() ? GetGameInstance()->GetSubsystem<UInventoryIconCache>() : nullptr;
+	if (IconCache && !m_CachedItem.bIsEmptySlot)
+	{
+		const TSoftObjectPtr<UTexture2D>& Icon = m_CachedItem.Item.InventoryItem.Icon;
+		NewIcon = IconCache->RequestIcon(Icon, FOnInventoryIconLoaded::CreateUObject(this, &UInventorySlotWidget::HandleIconLoaded, Icon.ToSoftObjectPath()));
+	}
+
+	if (NewIcon != m_Icon)
+	{
+		m_Icon = NewIcon;
+		OnIconChanged(m_Icon);
+	}
+}
+
+void UInventorySlotWidget::HandleIconLoaded(UTexture2D* Icon, FSoftObjectPath IconPath)
+{
+	// The widget might have been recycled for another slot while the icon was loading
+	if (m_CachedItem.bIsEmptySlot || m_CachedItem.Item.InventoryItem.Icon.ToSoftObjectPath() != IconPath)
+	{
+		return;
+	}
+
+	m_Icon = Icon;
+	OnIconChanged(m_Icon);
+}
+
 FReply UInventorySlotWidget::NativeOnMouseButtonDown(const FGeometry& InGeometry, const FPointerEvent& InMouseEvent)
 {
 	// return Super::NativeOnMouseButtonDown(InGeometry, InMouseEvent);
@@ -36,7 +144,7 @@ void UInventorySlotWidget::NativeOnDragDetected(const FGeometry& InGeometry, con
 	UInventoryDragDropOperation* const IDDO = NewObject<UInventoryDragDropOperation>();
 	if (IDDO)
 	{
-		FInventoryItemStack Item = GetItemByIndex().Item;
+		const FInventoryItemStack& Item = m_CachedItem.Item;
 		if (!Item.IsEmptySlot())
 		{
 			IDDO->DefaultDragVisual = this;
@@ -62,7 +170,7 @@ bool UInventorySlotWidget::NativeOnDrop(const FGeometry& InGeometry, const FDrag
 		}
 
 		// If the items are the same then try to combine the items
-		if (IDDO->m_Item == GetItemByIndex().Item)
+		if (IDDO->m_Item == m_CachedItem.Item)
 		{
 			IDDO->m_Inventory->CombineItemStack(IDDO->m_CurrentIndex, m_SlotID);
 
@@ -0,0 +1,161 @@
+/**
+ * Copyright 2019-2020 - Russ 'trdwll' Treadwell https://trdwll.com
+ */
+
+
+#include "InventoryStashComponent.h"
+
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "TimerManager.h"
+
+UInventoryStashComponent::UInventoryStashComponent()
+{
+	m_bReplicateSlots = false;
+	m_PageSize = 50;
+	m_bFlushPending = false;
+
+	m_InventoryRowsNum = 40;
+	m_InventoryColumnsNum = 50;
+	m_ActionBarSlotsNum = 0;
+}
+
+bool UInventoryStashComponent::CanView_Implementation(UInventoryComponent* Viewer) const
+{
+	return true;
+}
+
+void UInventoryStashComponent::MarkSlotDirty(int32 Index)
+{
+	Super::MarkSlotDirty(Index);
+
+	// Nobody is looking at the page so there's nothing to send
+	if (GetOwnerRole() != ROLE_Authority || !m_PageViewerCounts.Contains(Index / m_PageSize))
+	{
+		return;
+	}
+
+	m_DirtySlots.Add(Index);
+
+	if (!m_bFlushPending)
+	{
+		m_bFlushPending = true;
+		GetWorld()->GetTimerManager().SetTimerForNextTick(this, &UInventoryStashComponent::FlushPages);
+	}
+}
+
+void UInventoryStashComponent::SetViewerPage(UInventoryComponent* Viewer, int32 Page)
+{
+	if (GetOwnerRole() != ROLE_Authority || Viewer == nullptr || Viewer == this)
+	{
+		return;
+	}
+
+	if (Page >= GetPageCount() || (Page != INDEX_NONE && !CanView(Viewer)))
+	{
+		return;
+	}
+
+	int32 OldPage = INDEX_NONE;
+	if (m_ViewerPages.RemoveAndCopyValue(Viewer, OldPage))
+	{
+		AddPageViewer(OldPage, -1);
+	}
+
+	if (Page == INDEX_NONE)
+	{
+		return;
+	}
+
+	m_ViewerPages.Add(Viewer, Page);
+	AddPageViewer(Page, 1);
+
+	SendPage(Viewer, Page);
+}
+
+void UInventoryStashComponent::AddPageViewer(int32 Page, int32 Delta)
+{
+	int32& Count = m_PageViewerCounts.FindOrAdd(Page);
+	Count += Delta;
+
+	if (Count <= 0)
+	{
+		m_PageViewerCounts.Remove(Page);
+	}
+}
+
+void UInventoryStashComponent::SendPage(UInventoryComponent* Viewer, int32 Page)
+{
+	// A viewer without a connection is on the server and already has every slot
+	if (Viewer->GetOwner() == nullptr || Viewer->GetOwner()->GetNetConnection() == nullptr)
+	{
+		return;
+	}
+
+	const TArray<FInventoryItemStack>& Slots = GetInventoryItems();
+	const int32 First = Page * m_PageSize;
+	const int32 Last = FMath::Min(First + m_PageSize, Slots.Num());
+
+	TArray<FInventorySlotUpdate> Updates;
+	Updates.Reserve(Last - First);
+
+	for (int32 i = First; i < Last; i++)
+	{
+		Updates.Emplace(i, Slots[i]);
+	}
+
+	Viewer->Client_ReceiveStashSlots(this, Updates);
+}
+
+void UInventoryStashComponent::FlushPages()
+{
+	m_bFlushPending = false;
+
+	// Built once per page no matter how many are viewing it
+	const TArray<FInventoryItemStack>& Slots = GetInventoryItems();
+	TMap<int32, TArray<FInventorySlotUpdate>> PageUpdates;
+
+	for (int32 Index : m_DirtySlots)
+	{
+		if (Slots.IsValidIndex(Index))
+		{
+			PageUpdates.FindOrAdd(Index / m_PageSize).Emplace(Index, Slots[Index]);
+		}
+	}
+
+	m_DirtySlots.Reset();
+
+	for (auto It = m_ViewerPages.CreateIterator(); It; ++It)
+	{
+		UInventoryComponent* const Viewer = It.Key().Get();
+
+		// The viewer left without closing the stash
+		if (Viewer == nullptr)
+		{
+			AddPageViewer(It.Value(), -1);
+			It.RemoveCurrent();
+			continue;
+		}
+
+		const TArray<FInventorySlotUpdate>* const Updates = PageUpdates.Find(It.Value());
+		if (Updates && Viewer->GetOwner() && Viewer->GetOwner()->GetNetConnection())
+		{
+			Viewer->Client_ReceiveStashSlots(this, *Updates);
+		}
+	}
+}
+
+void UInventoryStashComponent::ReceiveSlots(const TArray<FInventorySlotUpdate>& Slots)
+{
+	if (GetOwnerRole() == ROLE_Authority)
+	{
+		return;
+	}
+
+	for (const FInventorySlotUpdate& Update : Slots)
+	{
+		ReceiveSlot(Update.Index, Update.Stack);
+	}
+
+	OnInventoryChanged.Broadcast();
+}
@@ -0,0 +1,312 @@
+/**
+ * Copyright 2019-2020 - Russ 'trdwll' Treadwell https://trdwll.com
+ */
+
+
+#include "InventorySubsystem.h"
+
+#include "InventoryComponent.h"
+#include "InventoryContainerComponent.h"
+#include "InventoryPluginSettings.h"
+#include "InventoryStashComponent.h"
+
+#include "Async/ParallelFor.h"
+
+#include "Engine/NetConnection.h"
+#include "GameFramework/Actor.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerState.h"
+#include "Engine/World.h"
+#include "TimerManager.h"
+
+void UInventorySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	const UInventoryPluginSettings* const Settings = GetDefault<UInventoryPluginSettings>();
+
+	m_OperationsPerSecond = Settings ? Settings->m_OperationsPerSecond : 20.0f;
+	m_OperationBurst = Settings ? Settings->m_OperationBurst : 40.0f;
+
+	m_DroppedOperations = 0;
+	m_CoalescedOperations = 0;
+
+	m_TimerWakeTime = -1.0f;
+	m_LastInstanceID = 0;
+
+	m_PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &UInventorySubsystem::PublishSnapshots);
+}
+
+void UInventorySubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldPostActorTick.Remove(m_PostActorTickHandle);
+	m_PendingSnapshots.Empty();
+
+	Super::Deinitialize();
+}
+
+void UInventorySubsystem::QueueSnapshot(UInventoryComponent* Inventory)
+{
+	m_PendingSnapshots.Add(Inventory);
+}
+
+void UInventorySubsystem::PublishSnapshots(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	if (World != GetWorld() || m_PendingSnapshots.Num() == 0)
+	{
+		return;
+	}
+
+	// Every change made this frame is in, so each snapshot is the state the frame ended with
+	TArray<TWeakObjectPtr<UInventoryComponent>> Pending = MoveTemp(m_PendingSnapshots);
+
+	for (const TWeakObjectPtr<UInventoryComponent>& Inventory : Pending)
+	{
+		if (Inventory.IsValid())
+		{
+			Inventory->PublishSnapshot();
+		}
+	}
+}
+
+void UInventorySubsystem::GetInventorySnapshots(TArray<FInventorySnapshotPtr>& OutSnapshots) const
+{
+	OutSnapshots.Reset(m_Inventories.Num());
+
+	for (const TWeakObjectPtr<UInventoryComponent>& Inventory : m_Inventories)
+	{
+		if (!Inventory.IsValid())
+		{
+			continue;
+		}
+
+		FInventorySnapshotPtr Snapshot = Inventory->GetSnapshot();
+		if (Snapshot.IsValid())
+		{
+			OutSnapshots.Add(MoveTemp(Snapshot));
+		}
+	}
+}
+
+void UInventorySubsystem::ScheduleTimer(UInventoryComponent* Inventory, EInventoryTimer Type, int32 SlotIndex, int32 Key, float Time)
+{
+	m_Timers.Schedule(Time, FInventoryTimer(Inventory, Type, SlotIndex, Key));
+	ArmTimers();
+}
+
+void UInventorySubsystem::ArmTimers()
+{
+	const float NextTime = m_Timers.GetNextEventTime();
+	if (NextTime < 0.0f)
+	{
+		return;
+	}
+
+	FTimerManager& TimerManager = GetWorld()->GetTimerManager();
+	if (TimerManager.IsTimerActive(m_TimerHandle) && m_TimerWakeTime <= NextTime)
+	{
+		return;
+	}
+
+	// A little late so the wheel has definitely reached the tick
+	const float Now = GetWorld()->GetTimeSeconds();
+	m_TimerWakeTime = NextTime;
+	TimerManager.SetTimer(m_TimerHandle, this, &UInventorySubsystem::AdvanceTimers, FMath::Max(NextTime - Now, 0.0f) + 0.01f, false);
+}
+
+void UInventorySubsystem::AdvanceTimers()
+{
+	m_Timers.Advance(GetWorld()->GetTimeSeconds(), [](const FInventoryTimer& Timer)
+	{
+		if (UInventoryComponent* const Inventory = Timer.Inventory.Get())
+		{
+			Inventory->OnInventoryTimer(Timer.Type, Timer.SlotIndex, Timer.Key);
+		}
+	});
+
+	// Anything scheduled while firing may have set the timer, start over from the wheel's next event
+	GetWorld()->GetTimerManager().ClearTimer(m_TimerHandle);
+	m_TimerWakeTime = -1.0f;
+	ArmTimers();
+}
+
+bool UInventorySubsystem::ConsumeOperationBudget(UNetConnection* Connection)
+{
+	if (Connection == nullptr || m_OperationsPerSecond <= 0.0f)
+	{
+		return true;
+	}
+
+	const float Now = GetWorld()->GetTimeSeconds();
+
+	FInventoryOperationBudget* Budget = m_Budgets.Find(Connection);
+	if (Budget == nullptr)
+	{
+		// Clear out connections that have gone away before adding a new one
+		for (auto It = m_Budgets.CreateIterator(); It; ++It)
+		{
+			if (!It->Key.IsValid())
+			{
+				It.RemoveCurrent();
+			}
+		}
+
+		Budget = &m_Budgets.Add(Connection);
+		Budget->Tokens = m_OperationBurst;
+		Budget->LastRefillTime = Now;
+	}
+
+	Budget->Tokens = FMath::Min(m_OperationBurst, Budget->Tokens + (Now - Budget->LastRefillTime) * m_OperationsPerSecond);
+	Budget->LastRefillTime = Now;
+
+	if (Budget->Tokens < 1.0f)
+	{
+		Budget->DroppedOperations++;
+		m_DroppedOperations++;
+		return false;
+	}
+
+	Budget->Tokens -= 1.0f;
+	return true;
+}
+
+void UInventorySubsystem::RecordCoalescedOperations(UNetConnection* Connection, int32 Count)
+{
+	m_CoalescedOperations += Count;
+
+	if (FInventoryOperationBudget* Budget = m_Budgets.Find(Connection))
+	{
+		Budget->CoalescedOperations += Count;
+	}
+}
+
+void UInventorySubsystem::RegisterInventory(UInventoryComponent* Inventory)
+{
+	m_Inventories.AddUnique(Inventory);
+}
+
+void UInventorySubsystem::UnregisterInventory(UInventoryComponent* Inventory)
+{
+	m_Inventories.RemoveSingleSwap(Inventory);
+}
+
+int32 UInventorySubsystem::TransformAllInventories(FInventorySlotTransform Transform)
+{
+	check(IsInGameThread());
+
+	TArray<UInventoryComponent*> Inventories;
+	Inventories.Reserve(m_Inventories.Num());
+
+	for (int32 i = m_Inventories.Num() - 1; i >= 0; i--)
+	{
+		if (UInventoryComponent* const Inventory = m_Inventories[i].Get())
+		{
+			Inventories.Add(Inventory);
+		}
+		else
+		{
+			m_Inventories.RemoveAtSwap(i);
+		}
+	}
+
+	// The game thread waits in ParallelFor so the slots can't change under the workers, each worker only writes its own change list
+	TArray<TArray<TPair<int32, FInventoryItemStack>>> Changes;
+	Changes.SetNum(Inventories.Num());
+
+	ParallelFor(Inventories.Num(), [&](int32 InventoryIndex)
+	{
+		const TArray<FInventoryItemStack>& Slots = Inventories[InventoryIndex]->GetInventoryItems();
+		TArray<TPair<int32, FInventoryItemStack>>& InventoryChanges = Changes[InventoryIndex];
+
+		for (int32 SlotIndex = 0; SlotIndex < Slots.Num(); SlotIndex++)
+		{
+			if (Slots[SlotIndex].IsEmptySlot())
+			{
+				continue;
+			}
+
+			FInventoryItemStack NewSlot = Slots[SlotIndex];
+			if (Transform(Slots[SlotIndex], NewSlot))
+			{
+				InventoryChanges.Emplace(SlotIndex, MoveTemp(NewSlot));
+			}
+		}
+	});
+
+	int32 SlotsChanged = 0;
+
+	for (int32 i = 0; i < Inventories.Num(); i++)
+	{
+		if (Changes[i].Num() > 0)
+		{
+			SlotsChanged += Inventories[i]->ApplySlotChanges(Changes[i]);
+		}
+	}
+
+	return SlotsChanged;
+}
+
+int32 UInventorySubsystem::RemoveItemsFromAllInventories(const TArray<FName>& ItemIDs)
+{
+	const TSet<FName> Removed(ItemIDs);
+
+	return TransformAllInventories([&Removed](const FInventoryItemStack& Slot, FInventoryItemStack& OutSlot)
+	{
+		if (Removed.Contains(Slot.InventoryItem.ID))
+		{
+			OutSlot = FInventoryItemStack();
+			return true;
+		}
+
+		return false;
+	});
+}
+
+/** Is the inventory a player's own? (not a bag, container or stash, even one owned by a player's pawn) */
+static bool IsPlayerInventory(const UInventoryComponent* Inventory)
+{
+	if (Inventory->IsA<UInventoryContainerComponent>() || Inventory->IsA<UInventoryStashComponent>())
+	{
+		return false;
+	}
+
+	const AActor* const Owner = Inventory->GetOwner();
+	const APawn* const Pawn = Cast<APawn>(Owner);
+
+	return (Pawn && Pawn->IsPlayerControlled()) || Cast<APlayerState>(Owner) || Cast<APlayerController>(Owner);
+}
+
+int32 UInventorySubsystem::GrantItemsToAllInventories(const TArray<FInventoryItemMeta>& Items)
+{
+	int32 Added = 0;
+
+	for (const TWeakObjectPtr<UInventoryComponent>& Inventory : m_Inventories)
+	{
+		if (Inventory.IsValid() && IsPlayerInventory(Inventory.Get()))
+		{
+			Added += Inventory->AddItems(Items);
+		}
+	}
+
+	return Added;
+}
+
+void UInventorySubsystem::SendItemDefinitions(int32 Version, const TArray<FInventoryItem>& Items, const TArray<FName>& RemovedItems)
+{
+	TSet<UNetConnection*> Sent;
+
+	for (const TWeakObjectPtr<UInventoryComponent>& Inventory : m_Inventories)
+	{
+		UNetConnection* const Connection = Inventory.IsValid() && Inventory->GetOwner() ? Inventory->GetOwner()->GetNetConnection() : nullptr;
+
+		// Inventories nobody owns have no one to send to, the listen server's player already has the definitions
+		if (Connection == nullptr || Sent.Contains(Connection))
+		{
+			continue;
+		}
+
+		Sent.Add(Connection);
+		Inventory->SendItemDefinitions(Version, Items, RemovedItems);
+	}
+}
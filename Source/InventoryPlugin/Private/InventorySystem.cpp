@@ -0,0 +1,96 @@
+/**
+ * Copyright 2019-2020 - Russ 'trdwll' Treadwell https://trdwll.com
+ */
+
+
+#include "InventorySystem.h"
+
+bool FInventoryItemStack::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	uint8 bEmpty = IsEmptySlot();
+	uint8 bFromTable = !InventoryItem.ID.IsNone();
+	uint8 bRotatedBit = bRotated;
+	uint8 bHasCondition = Condition != 1.0f || ConditionTime >= 0.0f;
+
+	Ar.SerializeBits(&bEmpty, 1);
+	Ar.SerializeBits(&bFromTable, 1);
+	Ar.SerializeBits(&bRotatedBit, 1);
+	Ar.SerializeBits(&bHasCondition, 1);
+
+	// Empty slots still send their version, it's how clients tell a slot changed
+	uint32 PackedVersion = (uint32)FMath::Max(Version, 0);
+	Ar.SerializeIntPacked(PackedVersion);
+
+	if (bEmpty)
+	{
+		if (Ar.IsLoading())
+		{
+			*this = FInventoryItemStack();
+		}
+	}
+	else
+	{
+		if (bFromTable)
+		{
+			FName ID = InventoryItem.ID;
+			Ar << ID;
+
+			// Keep the definition that was looked up if the slot still holds the same item
+			if (Ar.IsLoading() && ID != InventoryItem.ID)
+			{
+				InventoryItem = FInventoryItem();
+				InventoryItem.ID = ID;
+			}
+		}
+		else
+		{
+			FInventoryItem::StaticStruct()->SerializeBin(Ar, &InventoryItem);
+		}
+
+		uint32 PackedStackSize = (uint32)StackSize;
+		uint32 PackedInstanceID = (uint32)InstanceID;
+		Ar.SerializeIntPacked(PackedStackSize);
+		Ar.SerializeIntPacked(PackedInstanceID);
+
+		float NetCondition = Condition;
+		float NetConditionTime = ConditionTime;
+
+		if (bHasCondition)
+		{
+			Ar << NetCondition;
+			Ar << NetConditionTime;
+		}
+
+		if (Ar.IsLoading())
+		{
+			StackSize = (int32)PackedStackSize;
+			InstanceID = (int32)PackedInstanceID;
+			bRotated = bRotatedBit != 0;
+			Condition = bHasCondition ? NetCondition : 1.0f;
+			ConditionTime = bHasCondition ? NetConditionTime : -1.0f;
+		}
+	}
+
+	if (Ar.IsLoading())
+	{
+		Version = (int32)PackedVersion;
+	}
+
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
+
+bool FInventoryItemStack::Identical(const FInventoryItemStack* Other, uint32 PortFlags) const
+{
+	if (Other == nullptr)
+	{
+		return false;
+	}
+
+	const bool bSameItem = InventoryItem.ID.IsNone() || Other->InventoryItem.ID.IsNone()
+		? FInventoryItem::StaticStruct()->CompareScriptStruct(&InventoryItem, &Other->InventoryItem, PortFlags)
+		: InventoryItem.ID == Other->InventoryItem.ID;
+
+	return bSameItem && StackSize == Other->StackSize && Version == Other->Version && InstanceID == Other->InstanceID
+		&& bRotated == Other->bRotated && Condition == Other->Condition && ConditionTime == Other->ConditionTime;
+}
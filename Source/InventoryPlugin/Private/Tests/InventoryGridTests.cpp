@@ -0,0 +1,212 @@
+/**
+ * Copyright 2019-2020 - Russ 'trdwll' Treadwell https://trdwll.com
+ */
+
+
+#include "InventoryGrid.h"
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace InventoryGridTests
+{
+	static const int32 Rows = 10;
+	static const int32 Columns = 20;
+
+	/** The same grid one bool per cell, checked cell by cell like the grid did before it used bitboards. */
+	struct FNaiveGrid
+	{
+		TArray<bool> Cells;
+
+		FNaiveGrid() { Cells.Init(false, Rows * Columns); }
+
+		void Set(int32 Row, int32 Column, int32 Width, int32 Height)
+		{
+			for (int32 r = Row; r < Row + Height; r++)
+			{
+				for (int32 c = Column; c < Column + Width; c++)
+				{
+					Cells[r * Columns + c] = true;
+				}
+			}
+		}
+
+		bool Fits(int32 Row, int32 Column, int32 Width, int32 Height) const
+		{
+			if (Row + Height > Rows || Column + Width > Columns)
+			{
+				return false;
+			}
+
+			for (int32 r = Row; r < Row + Height; r++)
+			{
+				for (int32 c = Column; c < Column + Width; c++)
+				{
+					if (Cells[r * Columns + c])
+					{
+						return false;
+					}
+				}
+			}
+
+			return true;
+		}
+
+		bool FindFirstFit(int32 Width, int32 Height, int32& OutRow, int32& OutColumn) const
+		{
+			for (int32 Row = 0; Row < Rows; Row++)
+			{
+				for (int32 Column = 0; Column < Columns; Column++)
+				{
+					if (Fits(Row, Column, Width, Height))
+					{
+						OutRow = Row;
+						OutColumn = Column;
+						return true;
+					}
+				}
+			}
+
+			return false;
+		}
+	};
+
+	/** Take about a third of the cells at random, the same ones in both grids. */
+	static void FillRandomly(FRandomStream& Stream, FInventoryGrid& Grid, FNaiveGrid& Naive)
+	{
+		Grid.Reset(Rows, Columns);
+		Naive = FNaiveGrid();
+
+		for (int32 i = 0; i < (Rows * Columns) / 3; i++)
+		{
+			const int32 Row = Stream.RandHelper(Rows);
+			const int32 Column = Stream.RandHelper(Columns);
+
+			Grid.Set(Row, Column, 1, 1, true);
+			Naive.Set(Row, Column, 1, 1);
+		}
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryGridPlacementTest, "TRDWLL.Inventory.Grid.Placement", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FInventoryGridPlacementTest::RunTest(const FString& Parameters)
+{
+	using namespace InventoryGridTests;
+
+	FInventoryGrid Grid;
+	Grid.Reset(Rows, Columns);
+
+	int32 Row = INDEX_NONE;
+	int32 Column = INDEX_NONE;
+
+	TestTrue(TEXT("A 2x3 item fits in an empty grid"), Grid.FindFirstFit(2, 3, Row, Column));
+	TestTrue(TEXT("It goes in the top left"), Row == 0 && Column == 0);
+	Grid.Set(Row, Column, 2, 3, true);
+
+	TestTrue(TEXT("A second 2x3 item fits"), Grid.FindFirstFit(2, 3, Row, Column));
+	TestTrue(TEXT("It goes next to the first"), Row == 0 && Column == 2);
+	Grid.Set(Row, Column, 2, 3, true);
+
+	TestFalse(TEXT("Nothing fits over a taken cell"), Grid.Fits(2, 1, 1, 1));
+	TestTrue(TEXT("A cell below the items is free"), Grid.Fits(3, 0, 1, 1));
+	TestFalse(TEXT("Nothing fits past the right edge"), Grid.Fits(0, Columns - 1, 2, 1));
+	TestFalse(TEXT("Nothing fits past the bottom edge"), Grid.Fits(Rows - 1, 0, 1, 2));
+	TestFalse(TEXT("An item wider than the grid fits nowhere"), Grid.FindFirstFit(Columns + 1, 1, Row, Column));
+
+	Grid.Set(0, 0, 2, 3, false);
+	TestTrue(TEXT("Freed cells can be used again"), Grid.FindFirstFit(2, 3, Row, Column) && Row == 0 && Column == 0);
+
+	// Fill the grid a cell at a time, every cell has to be found exactly once
+	Grid.Reset(Rows, Columns);
+	int32 Placed = 0;
+
+	while (Grid.FindFirstFit(1, 1, Row, Column))
+	{
+		Grid.Set(Row, Column, 1, 1, true);
+		Placed++;
+	}
+
+	TestEqual(TEXT("Every cell is filled"), Placed, Rows * Columns);
+
+	// The bitboard has to pick the same place as checking every cell
+	FRandomStream Stream(1234);
+	FNaiveGrid Naive;
+
+	for (int32 Attempt = 0; Attempt < 100; Attempt++)
+	{
+		FillRandomly(Stream, Grid, Naive);
+
+		const int32 Width = 1 + Stream.RandHelper(4);
+		const int32 Height = 1 + Stream.RandHelper(4);
+
+		int32 NaiveRow = INDEX_NONE;
+		int32 NaiveColumn = INDEX_NONE;
+		Row = INDEX_NONE;
+		Column = INDEX_NONE;
+
+		const bool bFits = Grid.FindFirstFit(Width, Height, Row, Column);
+		const bool bNaiveFits = Naive.FindFirstFit(Width, Height, NaiveRow, NaiveColumn);
+
+		if (bFits != bNaiveFits || (bFits && (Row != NaiveRow || Column != NaiveColumn)))
+		{
+			AddError(FString::Printf(TEXT("A %dx%d item was placed at %d,%d but checking every cell places it at %d,%d"), Width, Height, Column, Row, NaiveColumn, NaiveRow));
+			break;
+		}
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryGridTimingTest, "TRDWLL.Inventory.Grid.Timing", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FInventoryGridTimingTest::RunTest(const FString& Parameters)
+{
+	using namespace InventoryGridTests;
+
+	static const int32 Grids = 200;
+	static const int32 SearchesPerGrid = 50;
+
+	FRandomStream Stream(5678);
+	FInventoryGrid Grid;
+	FNaiveGrid Naive;
+
+	double GridSeconds = 0.0;
+	double NaiveSeconds = 0.0;
+	int32 Found = 0;
+
+	for (int32 i = 0; i < Grids; i++)
+	{
+		FillRandomly(Stream, Grid, Naive);
+
+		int32 Row = 0;
+		int32 Column = 0;
+
+		double StartTime = FPlatformTime::Seconds();
+		for (int32 j = 0; j < SearchesPerGrid; j++)
+		{
+			Found += Grid.FindFirstFit(1 + j % 4, 1 + (j / 4) % 4, Row, Column) ? 1 : 0;
+		}
+		GridSeconds += FPlatformTime::Seconds() - StartTime;
+
+		StartTime = FPlatformTime::Seconds();
+		for (int32 j = 0; j < SearchesPerGrid; j++)
+		{
+			Found -= Naive.FindFirstFit(1 + j % 4, 1 + (j / 4) % 4, Row, Column) ? 1 : 0;
+		}
+		NaiveSeconds += FPlatformTime::Seconds() - StartTime;
+	}
+
+	const int32 Searches = Grids * SearchesPerGrid;
+
+	AddInfo(FString::Printf(TEXT("%d searches of a %dx%d grid: bitboard %.3f ms, per cell %.3f ms (%.1fx)"),
+		Searches, Rows, Columns, GridSeconds * 1000.0, NaiveSeconds * 1000.0, GridSeconds > 0.0 ? NaiveSeconds / GridSeconds : 0.0));
+
+	TestEqual(TEXT("Both find room as often"), Found, 0);
+	TestTrue(TEXT("The bitboard is faster than checking every cell"), GridSeconds < NaiveSeconds);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,84 @@
+/**
+ * Copyright 2019-2020 - Russ 'trdwll' Treadwell https://trdwll.com
+ */
+
+
+#include "InventoryItemDatabase.h"
+
+#include "Engine/DataTable.h"
+#include "HAL/FileManager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/ObjectReader.h"
+#include "Serialization/ObjectWriter.h"
+#include "UObject/Package.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryItemDatabaseColdStartTest, "TRDWLL.Inventory.ItemDatabase.ColdStart", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FInventoryItemDatabaseColdStartTest::RunTest(const FString& Parameters)
+{
+	static const int32 Rows = 50000;
+
+	// A synthetic item DataTable, every row with its own text so the string pool is realistic
+	UDataTable* const Table = NewObject<UDataTable>(GetTransientPackage());
+	Table->RowStruct = FInventoryItem::StaticStruct();
+
+	for (int32 i = 0; i < Rows; i++)
+	{
+		FInventoryItem Item;
+		Item.Title = FString::Printf(TEXT("Item %d"), i);
+		Item.PluralTitle = FString::Printf(TEXT("Items %d"), i);
+		Item.Description = FString::Printf(TEXT("Synthetic item %d for measuring how long the item definitions take to load"), i);
+		Item.MaxStackSize = 1 + i % 100;
+
+		Table->AddRow(FName(*FString::Printf(TEXT("Item_%d"), i)), Item);
+	}
+
+	// What loading the DataTable's package does for the rows, without the file IO
+	TArray<uint8> TableBytes;
+	FObjectWriter Writer(Table, TableBytes);
+
+	const FString Filename = FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("InventoryItemDatabaseColdStart.bin"));
+
+	TArray<uint8> Blob;
+	if (!TestTrue(TEXT("The DataTable is baked"), FInventoryItemDatabase::Write(*Table, Blob)) || !TestTrue(TEXT("The database is written"), FFileHelper::SaveArrayToFile(Blob, *Filename)))
+	{
+		return false;
+	}
+
+	double StartTime = FPlatformTime::Seconds();
+
+	UDataTable* const LoadedTable = NewObject<UDataTable>(GetTransientPackage());
+	FObjectReader Reader(LoadedTable, TableBytes);
+
+	const double TableMilliseconds = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+	StartTime = FPlatformTime::Seconds();
+
+	FInventoryItemDatabase Database;
+	const bool bLoaded = Database.Load(Filename);
+
+	const double DatabaseMilliseconds = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+	AddInfo(FString::Printf(TEXT("%d items: DataTable %.2f ms, mapped database %.2f ms (%d bytes, %.1fx)"),
+		Rows, TableMilliseconds, DatabaseMilliseconds, Blob.Num(), DatabaseMilliseconds > 0.0 ? TableMilliseconds / DatabaseMilliseconds : 0.0));
+
+	TestTrue(TEXT("The database is loaded"), bLoaded);
+	TestEqual(TEXT("The DataTable has every row"), LoadedTable->GetRowMap().Num(), Rows);
+	TestEqual(TEXT("The database has every item"), Database.Num(), Rows);
+
+	const FInventoryItem* const Item = Database.FindItem(FName(TEXT("Item_1234")));
+	TestTrue(TEXT("An item is read back from the database"), Item && Item->Title == TEXT("Item 1234") && Item->MaxStackSize == 1 + 1234 % 100);
+
+	TestTrue(TEXT("The mapped database loads faster than the DataTable"), DatabaseMilliseconds < TableMilliseconds);
+
+	Database.Unload();
+	IFileManager::Get().Delete(*Filename);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,137 @@
+/**
+ * Copyright 2019-2020 - Russ 'trdwll' Treadwell https://trdwll.com
+ */
+
+
+#include "InventoryLootTable.h"
+
+#include "Misc/AutomationTest.h"
+#include "UObject/Package.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace InventoryLootTableTests
+{
+	static const float Weights[] = { 1.0f, 2.0f, 3.0f, 4.0f, 0.0f };
+	static const int32 EntryCount = sizeof(Weights) / sizeof(Weights[0]);
+
+	static FName GetItemName(int32 Index)
+	{
+		return FName(*FString::Printf(TEXT("LootTest%d"), Index));
+	}
+
+	/** A table with one entry per weight, each dropping 1 of its own item. */
+	static UInventoryLootTable* CreateTable()
+	{
+		TArray<FLootTableEntry> Entries;
+
+		for (int32 i = 0; i < EntryCount; i++)
+		{
+			FLootTableEntry& Entry = Entries.AddDefaulted_GetRef();
+			Entry.ItemRowName = GetItemName(i);
+			Entry.Weight = Weights[i];
+		}
+
+		UInventoryLootTable* const Table = NewObject<UInventoryLootTable>(GetTransientPackage());
+		Table->SetEntries(Entries);
+
+		return Table;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryLootTableDistributionTest, "TRDWLL.Inventory.LootTable.Distribution", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FInventoryLootTableDistributionTest::RunTest(const FString& Parameters)
+{
+	using namespace InventoryLootTableTests;
+
+	static const int32 Rolls = 200000;
+
+	UInventoryLootTable* const Table = CreateTable();
+
+	TMap<FName, int32> Counts;
+	TArray<FInventoryItemMeta> Items;
+	FRandomStream Stream(42);
+
+	for (int32 i = 0; i < Rolls; i++)
+	{
+		Items.Reset();
+		Table->Roll(Stream, Items);
+
+		for (const FInventoryItemMeta& Item : Items)
+		{
+			Counts.FindOrAdd(Item.ItemRowName) += Item.Quantity;
+		}
+	}
+
+	float TotalWeight = 0.0f;
+	for (float Weight : Weights)
+	{
+		TotalWeight += Weight;
+	}
+
+	for (int32 i = 0; i < EntryCount; i++)
+	{
+		const float Expected = Weights[i] / TotalWeight;
+		const float Observed = (float)Counts.FindRef(GetItemName(i)) / Rolls;
+
+		// Well over 4 standard deviations at this many rolls
+		TestEqual(FString::Printf(TEXT("Entry %d with weight %.0f drops as often as its weight says"), i, Weights[i]), Observed, Expected, 0.01f);
+	}
+
+	TestEqual(TEXT("An entry without a weight never drops"), Counts.FindRef(GetItemName(EntryCount - 1)), 0);
+
+	// The same seed always gives the same loot
+	const TArray<FInventoryItemMeta> First = Table->RollLoot(7);
+	const TArray<FInventoryItemMeta> Second = Table->RollLoot(7);
+
+	TestTrue(TEXT("Rolling the same seed twice drops the same items"), First.Num() == 1 && Second.Num() == 1 && First[0].ItemRowName == Second[0].ItemRowName);
+
+	// A table that contains itself has the nested table taken out when it's compiled
+	TArray<FLootTableEntry> Entries;
+	FLootTableEntry& Nested = Entries.AddDefaulted_GetRef();
+	Nested.NestedTable = Table;
+	Nested.MinQuantity = 50;
+	Nested.MaxQuantity = 50;
+
+	Table->SetEntries(Entries);
+
+	TestTrue(TEXT("A table that contained itself rolls without dropping anything"), Table->RollLoot(7).Num() == 0);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInventoryLootTableThroughputTest, "TRDWLL.Inventory.LootTable.Throughput", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FInventoryLootTableThroughputTest::RunTest(const FString& Parameters)
+{
+	using namespace InventoryLootTableTests;
+
+	static const int32 Rolls = 100000;
+
+	UInventoryLootTable* const Table = CreateTable();
+
+	TArray<FInventoryItemMeta> Items;
+	Items.Reserve(Rolls);
+
+	FRandomStream Stream(42);
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	for (int32 i = 0; i < Rolls; i++)
+	{
+		Table->Roll(Stream, Items);
+	}
+
+	const double Milliseconds = FMath::Max((FPlatformTime::Seconds() - StartTime) * 1000.0, 0.001);
+	const double ItemsPerMillisecond = Items.Num() / Milliseconds;
+
+	AddInfo(FString::Printf(TEXT("%d rolls dropped %d items in %.3f ms (%.0f items per ms)"), Rolls, Items.Num(), Milliseconds, ItemsPerMillisecond));
+
+	TestEqual(TEXT("Every roll dropped an item"), Items.Num(), Rolls);
+	TestTrue(TEXT("Thousands of items are rolled per millisecond"), ItemsPerMillisecond >= 1000.0);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
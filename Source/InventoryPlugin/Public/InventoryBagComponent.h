@@ -0,0 +1,74 @@
+/**
+ * Copyright 2019-2020 - Russ 'trdwll' Treadwell https://trdwll.com
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "InventoryContainerComponent.h"
+
+#include "InventoryBagComponent.generated.h"
+
+/**
+ * The inventory of a bag item sitting in a slot of another inventory. It's created the first time the bag is opened and
+ * releases its slots like any other container, while the parent keeps the totals and weight of what's inside.
+ */
+UCLASS(ClassGroup=(TRDWLL), NotBlueprintable)
+class INVENTORYPLUGIN_API UInventoryBagComponent final : public UInventoryContainerComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	UInventoryBagComponent();
+
+	/**
+	 * Server: Set up the bag for a stack of another inventory, called before the bag is registered.
+	 *
+	 * @param UInventoryComponent* Parent The inventory the bag is in
+	 * @param int32 InstanceID The instance ID of the bag's stack
+	 * @param int32 Slots How many slots the bag has
+	 */
+	void InitializeBag(UInventoryComponent* Parent, int32 InstanceID, int32 Slots);
+
+	/** Server: Fill the bag with the contents of a bag that was moved from another inventory. */
+	void AdoptContents(const TArray<FInventoryItemMeta>& Contents);
+
+	/** Server: The totals of everything in the bag, whether the slots are created or not. */
+	FORCEINLINE const TMap<FName, int32>& GetContentTotals() const { return m_ContentTotals; }
+
+	/** Server: The weight of everything in the bag. */
+	FORCEINLINE float GetContentWeight() const { return m_ContentWeight; }
+
+	/** Get the inventory the bag is in. */
+	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory Bag")
+	FORCEINLINE UInventoryComponent* GetParentInventory() const { return m_ParentInventory; }
+
+	/** Get the instance ID of the bag's stack in the parent inventory. */
+	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory Bag")
+	FORCEINLINE int32 GetBagInstanceID() const { return m_BagInstanceID; }
+
+	virtual float GetWeightLeft() const override;
+
+protected:
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	virtual void OnItemTotalChanged(FName Key, int32 Delta, float WeightDelta) override;
+
+	virtual bool CanHoldBags() const override { return false; }
+
+private:
+
+	UPROPERTY(Replicated)
+	UInventoryComponent* m_ParentInventory;
+
+	UPROPERTY(Replicated)
+	int32 m_BagInstanceID;
+
+	/** Everything that's been put in the bag, kept while the slots are released. */
+	TMap<FName, int32> m_ContentTotals;
+
+	float m_ContentWeight;
+};
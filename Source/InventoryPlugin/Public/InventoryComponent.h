@@ -6,9 +6,14 @@
 
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
+#include "Engine/StreamableManager.h"
+#include "WorldCollision.h"
 
 #include "InventorySystem.h"
+#include "InventoryGrid.h"
+#include "InventoryInstanceData.h"
 #include "InventoryPluginSettings.h"
+#include "InventorySubsystem.h"
 
 #include "InventoryComponent.generated.h"
 
@@ -20,11 +25,185 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_FourParams(FOnItemMovedDelegate, AActor*, Ins
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnItemExecDelegate, AActor*, Instigator, const FInventoryItemStack&, Item, EInventoryItemAction, Action);
 
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnItemCastDelegate, AActor*, Instigator, const FInventoryItemStack&, Item);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnCooldownEndedDelegate, FName, CooldownGroup);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnItemExpiredDelegate, AActor*, Instigator, const FInventoryItemStack&, ItemExpired);
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnSlotChangedDelegate, int32, SlotIndex);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnInstanceDataChangedDelegate, int32, InstanceID);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnCraftableRecipesChangedDelegate);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnItemCraftedDelegate, AActor*, Instigator, class UInventoryRecipe*, Recipe, int32, Count);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnInventoryChangedDelegate);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnEncumbranceChangedDelegate, int32, NewLevel, int32, OldLevel);
+
+DECLARE_DYNAMIC_DELEGATE_RetVal_OneParam(bool, FInventoryItemFilter, const FInventoryItemStack&, Item);
+
 // TODO: FOnItemCombined
 
+/** What SortAndConsolidate orders the stacks by. Ties are ordered by item ID. */
+UENUM(BlueprintType)
+enum class EInventorySortKey : uint8
+{
+	ISK_ItemID		UMETA(DisplayName = "Item ID"),
+	ISK_Category	UMETA(DisplayName = "Category"),   // The item action, so food, gear and the rest end up together
+	ISK_Weight		UMETA(DisplayName = "Weight"),     // The weight of the whole stack
+	ISK_StackSize	UMETA(DisplayName = "Stack Size"),
+};
+
+/** A cooldown group that can't be used until EndTime. */
+USTRUCT()
+struct FInventoryCooldown
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FName Group;
+
+	/** The server time the cooldown ends. */
+	UPROPERTY()
+	float EndTime;
+
+	FInventoryCooldown() : EndTime(0.0f) {}
+	FInventoryCooldown(const FName& group, float endTime) : Group(group), EndTime(endTime) {}
+};
+
+/** An item that is being used over time. */
+USTRUCT(BlueprintType)
+struct FInventoryCast
+{
+	GENERATED_BODY()
+
+	/** The slot of the item, INDEX_NONE if nothing is being cast. */
+	UPROPERTY(BlueprintReadOnly, Category = "Inventory System")
+	int32 SlotIndex;
+
+	/** The server times the cast started and finishes. */
+	UPROPERTY(BlueprintReadOnly, Category = "Inventory System")
+	float StartTime;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Inventory System")
+	float EndTime;
+
+	/** Tells the timer of this cast apart from the timers of earlier casts. (server only) */
+	int32 Serial;
+
+	FInventoryCast() : SlotIndex(INDEX_NONE), StartTime(0.0f), EndTime(0.0f), Serial(0) {}
+};
+
+/** A slot sent to a client outside of property replication, such as a page of a shared stash. */
+USTRUCT()
+struct FInventorySlotUpdate
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	int32 Index;
+
+	UPROPERTY()
+	FInventoryItemStack Stack;
+
+	FInventorySlotUpdate() : Index(INDEX_NONE) {}
+	FInventorySlotUpdate(int32 index, const FInventoryItemStack& stack) : Index(index), Stack(stack) {}
+};
+
+/** A slot that the owning client has changed locally and is waiting on the server to confirm. */
+struct FPredictedSlot
+{
+	/** What the slot should look like once the server applies the move. */
+	FInventoryItemStack Stack;
+
+	/** The sequence of the operation that produced this prediction. */
+	int32 PredictionKey;
+
+	/** The version of the replicated slot when the prediction was made. */
+	int32 BaseVersion;
+
+	/** When the server acknowledged the operation. */
+	float Time;
+
+	/** Has the server accepted the move? */
+	bool bConfirmed;
+
+	FPredictedSlot() : PredictionKey(0), BaseVersion(0), Time(0.0f), bConfirmed(false) {}
+};
+
+/**
+ * The slots of an inventory as they were at the end of a frame. Never changed once published so any thread can read it without locking,
+ * an inventory publishes a new one at the end of a frame it changed in and readers keep the old one alive for as long as they hold it.
+ */
+struct FInventorySnapshot
+{
+	/** How many slots are in a block, a snapshot only copies the blocks that changed since the one before it and shares the rest. */
+	static const int32 SlotsPerBlock = 32;
+
+	typedef TSharedPtr<const TArray<FInventoryItemStack>, ESPMode::ThreadSafe> FSlotBlockPtr;
+
+	/** Every slot including the action bar, SlotsPerBlock at a time. Use GetSlot to read them. */
+	TArray<FSlotBlockPtr> SlotBlocks;
+
+	/** How many slots there are in all the blocks. */
+	int32 NumSlots;
+
+	/** How many of each item the slots hold, by item key. */
+	TMap<FName, int32> ItemTotals;
+
+	/** The weight of the slots and what's in their bags. */
+	float Weight;
+
+	/** GFrameCounter when it was published. */
+	uint64 Frame;
+
+	/** Goes up by 1 every time the inventory publishes a snapshot. */
+	int32 Serial;
+
+	FInventorySnapshot() : NumSlots(0), Weight(0.0f), Frame(0), Serial(0) {}
+
+	const FInventoryItemStack& GetSlot(int32 Index) const
+	{
+		check(Index >= 0 && Index < NumSlots);
+		return (*SlotBlocks[Index / SlotsPerBlock])[Index % SlotsPerBlock];
+	}
+};
+
+typedef TSharedPtr<const FInventorySnapshot, ESPMode::ThreadSafe> FInventorySnapshotPtr;
+
+enum class EInventoryOperation : uint8
+{
+	Swap,
+	Combine,
+	Split,
+	Drop,
+	Exec,
+	Sort,
+	Craft
+};
+
+/** An operation the owning client has sent to the server and is keeping around until it's acknowledged. */
+struct FInventoryOperation
+{
+	EInventoryOperation Type;
+
+	/** Increases by 1 for every operation the client sends. */
+	int32 Sequence;
+
+	/** The slot indexes and quantity the operation was called with. */
+	int32 FirstIndex;
+	int32 SecondIndex;
+	int32 Quantity;
+
+	/** The version of the slot the client saw, so the server can tell if the slot changed under it. (INDEX_NONE to skip the check) */
+	int32 SlotVersion;
+
+	/** When the operation was last sent. */
+	float LastSentTime;
+
+	FInventoryOperation() : Type(EInventoryOperation::Swap), Sequence(0), FirstIndex(INDEX_NONE), SecondIndex(INDEX_NONE), Quantity(0), SlotVersion(INDEX_NONE), LastSentTime(0.0f) {}
+	FInventoryOperation(EInventoryOperation type, int32 firstIndex, int32 secondIndex = INDEX_NONE, int32 quantity = 0) : Type(type), Sequence(0), FirstIndex(firstIndex), SecondIndex(secondIndex), Quantity(quantity), SlotVersion(INDEX_NONE), LastSentTime(0.0f) {}
+};
+
 
 UCLASS(ClassGroup=(TRDWLL), meta=(BlueprintSpawnableComponent))
-class INVENTORYPLUGIN_API UInventoryComponent final : public UActorComponent
+class INVENTORYPLUGIN_API UInventoryComponent : public UActorComponent
 {
 	GENERATED_BODY()
 
@@ -33,9 +212,11 @@ class INVENTORYPLUGIN_API UInventoryComponent final : public UActorComponent
 
 protected:
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	// virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 
 	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+	virtual void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
 
 public:	
 	UInventoryComponent();
@@ -54,27 +235,134 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "TRDWLL|Inventory Component", meta = (DisplayName = "Inventory Columns"))
 	uint8 m_InventoryColumnsNum;
 
+	/** Should items take up as many grid cells as their footprint? (the grid can be at most 64 columns wide) The action bar is always 1 item per slot. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "TRDWLL|Inventory Component", meta = (DisplayName = "Use Item Footprints"))
+	bool m_bUseFootprints;
+
 	/** How many slots should the action bar have? */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "TRDWLL|Inventory Component", meta = (DisplayName = "Action Bar Slots"))
 	uint8 m_ActionBarSlotsNum;
 
+	/** How much weight the inventory can hold, including what's in its bags. (0 for no limit) */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "TRDWLL|Inventory Component", meta = (ClampMin = "0", DisplayName = "Max Weight"))
+	float m_MaxWeight;
+
+	/** The total weights the owner gets more encumbered at, the encumbrance level is how many of them the weight has reached. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "TRDWLL|Inventory Component", meta = (DisplayName = "Encumbrance Thresholds"))
+	TArray<float> m_EncumbranceThresholds;
+
 private:
 	/** The characters inventory array. */
-	UPROPERTY(Replicated)
+	UPROPERTY(ReplicatedUsing = OnRep_InventoryItems)
 	TArray<FInventoryItemStack> m_InventoryItems;
 
+	/** The cooldown groups that have been used recently, only the ones that haven't ended. */
+	UPROPERTY(ReplicatedUsing = OnRep_Cooldowns)
+	TArray<FInventoryCooldown> m_Cooldowns;
+
+	/** Index into m_Cooldowns by group. */
+	TMap<FName, int32> m_CooldownIndex;
+
+	UFUNCTION()
+	void OnRep_Cooldowns();
+
+	/** The item being used over time. */
+	UPROPERTY(Replicated)
+	FInventoryCast m_ActiveCast;
+
+	int32 m_LastCastSerial;
+
+	/** Server: RPC to interrupt the current cast */
+	UFUNCTION(Server, Unreliable, WithValidation)
+	void Server_CancelCast();
+
+	/** Server: RPC to craft a recipe */
+	UFUNCTION(Server, Unreliable, WithValidation)
+	void Server_CraftRecipe(int32 RecipeIndex, int32 Count, int32 Sequence);
+
+	/** Per instance data of the stacks that have any, replicated separately from the slots. */
+	UPROPERTY(Replicated)
+	FInventoryInstanceDataArray m_InstanceData;
+
+	/** Instances that left a slot and may not be in any slot anymore. (server only) */
+	TSet<int32> m_OrphanedInstances;
+	bool m_bPruneInstancesPending;
+
+	/** Remove the data of instances that aren't in any slot anymore. */
+	void PruneInstanceData();
+
+	/** The last version of each slot that OnSlotChanged was broadcast for. (clients only) */
+	TArray<int32> m_SeenSlotVersions;
+
+	UFUNCTION()
+	void OnRep_InventoryItems();
+
+	/** How many slots hold an item of each world item class. (server only) */
+	TMap<FSoftObjectPath, int32> m_HeldClassCounts;
+
+	/** Keeps the world item classes of held items loaded so drops don't have to load them. (server only) */
+	TMap<FSoftObjectPath, TSharedPtr<FStreamableHandle>> m_ClassHandles;
+
+	/** Items that were dropped before their world item class had loaded. */
+	TMap<FSoftObjectPath, TArray<FInventoryItemStack>> m_PendingDrops;
+
+	/** Track the world item class of a stack entering or leaving a slot, loading or releasing it as needed. */
+	void UpdateHeldClass(const FInventoryItemStack& Stack, int32 Delta);
+
+	/** Release the handle keeping a world item class loaded if nothing needs it anymore. */
+	void ReleaseHeldClass(const FSoftObjectPath& ClassPath);
+
+	/** Called when the class of queued drops has finished loading. */
+	void OnDropClassLoaded(FSoftObjectPath ClassPath);
+
+	/**
+	 * Spawn the world item for a stack in front of the character.
+	 *
+	 * @param const FInventoryItemStack& Item The stack that should be spawned
+	 * @return The spawned actor or nullptr if it couldn't be spawned
+	 */
+	class AInventoryBaseItem* SpawnDroppedItem(const FInventoryItemStack& Item);
+
+	/**
+	 * Server: Spawn the world item for a stack, or queue it to be spawned once its class has loaded.
+	 *
+	 * @param const FInventoryItemStack& Item The stack that should be dropped
+	 * @return False if it can't be dropped at all (no world item class or no character to drop it), the caller still has it
+	 */
+	bool SpawnOrQueueDrop(const FInventoryItemStack& Item);
+
 	/** Server: RPC to call pickup on the server */
 	UFUNCTION(Server, Unreliable, WithValidation)
 	void Server_PickupItem();
 
+	/**
+	 * Get the line the character uses items along.
+	 *
+	 * @return False if the character has no controller to look through
+	 */
+	bool GetUseTrace(FVector& OutStart, FVector& OutEnd, FCollisionQueryParams& OutParams) const;
+
+	/** Server: Check for the result of the pickup trace, from the frame after it was requested until it's in. */
+	void CheckPickupTrace();
+
+	/** Server: Put a world item into the inventory and destroy it. */
+	void PickupActor(class AInventoryBaseItem* Item);
+
+	/** The pickup trace, polled rather than given a delegate so the world never holds on to anything of the component. */
+	FTraceHandle m_PickupTrace;
+
+	/** Server: Is a pickup trace waiting on its result? */
+	bool m_bPickupTracePending;
+
 	/**
 	 * Server: RPC to swap items in the inventory array
 	 * 
 	 * @param int32 CurrentIndex The current index of the item that should be swapped
 	 * @param int32 NewIndex The new index of the item
+	 * @param int32 Sequence The sequence of the operation (0 if it was called on the server)
 	 */
 	UFUNCTION(Server, Unreliable, WithValidation)
-	void Server_SwapItem(int32 CurrentIndex, int32 NewIndex);
+	void Server_SwapItem(int32 CurrentIndex, int32 NewIndex, int32 Sequence);
 
 	/**
 	 * Server: RPC to call drop on the server
@@ -82,10 +370,16 @@ private:
 	 * @param const FInventoryItemStack& Item The item that should be dropped
 	 */
 	UFUNCTION(Server, Unreliable, WithValidation)
-	void Server_DropItem(int32 ItemIndex, int32 Quantity = 1);
+	void Server_DropItem(int32 ItemIndex, int32 Quantity, int32 Sequence);
 
+	/**
+	 * Server: RPC to use the item in a slot
+	 *
+	 * @param int32 SlotIndex The slot of the item
+	 * @param int32 SlotVersion The version of the slot the client saw (INDEX_NONE to skip the check)
+	 */
 	UFUNCTION(Server, Unreliable, WithValidation)
-	void Server_ExecItem(const FInventoryItemStack& Item);
+	void Server_ExecItem(int32 SlotIndex, int32 SlotVersion, int32 Sequence);
 
 	/*UFUNCTION(Server, Unreliable, WithValidation)
 	void Server_AddToStack(const FInventoryItem& ItemToAdd, const FInventoryItemStack& Stack, int32 Quantity = 1);
@@ -93,11 +387,142 @@ private:
 	UFUNCTION(Server, Unreliable, WithValidation)
 	void Server_RemoveFromStack(const FInventoryItem& ItemToRemove, const FInventoryItemStack& Stack, int32 Quantity = 1);*/
 
+	/**
+	 * Server: RPC to move part of a stack into the next empty slot
+	 *
+	 * @param int32 SlotIndex The slot of the stack that should be split
+	 * @param int32 Quantity How many should be moved into the new stack
+	 * @param int32 SlotVersion The version of the slot the client saw (INDEX_NONE to skip the check)
+	 */
 	UFUNCTION(Server, Unreliable, WithValidation)
-	void Server_SplitItemStack(const FInventoryItemStack& Item, int32 NewStackSize);
+	void Server_SplitItemStack(int32 SlotIndex, int32 Quantity, int32 SlotVersion, int32 Sequence);
 
 	UFUNCTION(Server, Unreliable, WithValidation)
-	void Server_CombineItemStack(int32 ItemToCombine, int32 TargetItem);
+	void Server_CombineItemStack(int32 ItemToCombine, int32 TargetItem, int32 Sequence);
+
+	/**
+	 * Server: RPC to merge the partial stacks and sort the inventory slots
+	 *
+	 * @param EInventorySortKey SortKey What the stacks are ordered by
+	 * @param bool bDescending Should the order be reversed?
+	 */
+	UFUNCTION(Server, Unreliable, WithValidation)
+	void Server_SortAndConsolidate(EInventorySortKey SortKey, bool bDescending, int32 Sequence);
+
+	/**
+	 * Client: RPC acknowledging every operation up to and including Sequence
+	 *
+	 * @param int32 Sequence The last operation the server has applied
+	 * @param const TArray<int32>& Rejected The recent operations that were rejected, their predictions are rolled back
+	 */
+	UFUNCTION(Client, Unreliable)
+	void Client_AckOperation(int32 Sequence, const TArray<int32>& Rejected);
+
+	/**
+	 * Client: RPC with slots of a shared stash page the owner is viewing (reliable since only the changes are sent)
+	 *
+	 * @param UInventoryStashComponent* Stash The stash the slots are from
+	 * @param const TArray<FInventorySlotUpdate>& Slots The slots that changed
+	 */
+	UFUNCTION(Client, Reliable)
+	void Client_ReceiveStashSlots(class UInventoryStashComponent* Stash, const TArray<FInventorySlotUpdate>& Slots);
+
+	/**
+	 * Client: RPC with item definitions that changed on the server while running
+	 *
+	 * @param int32 Version The registry version of the server
+	 * @param const TArray<FInventoryItem>& Items The definitions that changed
+	 * @param const TArray<FName>& RemovedItems The items that no longer have a definition
+	 */
+	UFUNCTION(Client, Reliable)
+	void Client_ReceiveItemDefinitions(int32 Version, const TArray<FInventoryItem>& Items, const TArray<FName>& RemovedItems);
+
+	/** Server: RPC asking for the definitions that changed before the client joined */
+	UFUNCTION(Server, Reliable, WithValidation)
+	void Server_RequestItemDefinitions(int32 KnownVersion);
+
+	FDelegateHandle m_ItemDefinitionsHandle;
+
+	/** Refresh the copies of definitions that changed in the slots, in place so nothing is sent. */
+	void OnItemDefinitionsChanged(const TSet<FName>& ItemIDs);
+
+	/** Client: Fill in the definition of a stack that was sent with only its row name. */
+	void ResolveItem(FInventoryItemStack& Stack);
+
+	/** Server: RPC to view a page of a shared stash */
+	UFUNCTION(Server, Reliable, WithValidation)
+	void Server_ViewStashPage(class UInventoryStashComponent* Stash, int32 Page);
+
+	/** Slots the owning client has changed locally, shown on top of m_InventoryItems until the server catches up. */
+	TMap<int32, FPredictedSlot> m_PredictedSlots;
+
+	FTimerHandle m_PredictionTimer;
+
+	/** The sequence of the last operation the client sent. */
+	int32 m_LastSentSequence;
+
+	/** Operations the server hasn't acknowledged yet, oldest first. (owning client only) */
+	TArray<FInventoryOperation> m_UnackedOperations;
+
+	FTimerHandle m_ResendTimer;
+
+	/** The sequence of the last operation the server applied. (server only) */
+	int32 m_LastAppliedSequence;
+
+	/** The most recent operations the server rejected, sent with every ack so a lost one can't be confirmed by a later ack. (server only) */
+	TArray<int32> m_RejectedSequences;
+
+	/** The sequence of the last operation the server queued. (server only) */
+	int32 m_LastReceivedSequence;
+
+	/** Operations received this frame, applied together on the next tick. (server only) */
+	TArray<FInventoryOperation> m_PendingOperations;
+
+	/**
+	 * Send an operation to the server. On clients it gets a sequence and is re-sent until the server acknowledges it.
+	 *
+	 * @return The sequence of the operation, 0 if it was called on the server
+	 */
+	int32 QueueOperation(FInventoryOperation Operation);
+
+	/** Call the server RPC for an operation. */
+	void SendOperation(FInventoryOperation& Operation);
+
+	/** Re-send the operations that haven't been acknowledged in time. */
+	void ResendOperations();
+
+	/** Server: Should the operation with this sequence be applied? Duplicates are acknowledged again and skipped. */
+	bool ShouldApplyOperation(int32 Sequence);
+
+	/** Server: Record that an operation was applied and acknowledge it to the owning client. */
+	void AckOperation(int32 Sequence);
+
+	/** Server: Record that an operation was rejected so every ack after it tells the client to roll it back. */
+	void RejectOperation(int32 Sequence);
+
+	/** Server: Check the connection's budget and the sequence of an operation and queue it to be applied. */
+	void ReceiveOperation(FInventoryOperation Operation, int32 Sequence);
+
+	/** Server: Apply the operations received this frame, dropping the ones that cancel each other out. */
+	void FlushOperations();
+
+	/** Server: Apply a single operation, returns false if it was rejected. */
+	bool ApplyOperation(const FInventoryOperation& Operation);
+
+	/** Get the slot version to send with an operation on a slot. */
+	int32 GetExpectedSlotVersion(int32 SlotIndex) const;
+
+	/** Server: Is the slot still the version the client saw? */
+	bool IsExpectedSlot(int32 SlotIndex, int32 SlotVersion) const;
+
+	/** Is the index inside the configured slot count? Cheap enough for RPC validation. */
+	FORCEINLINE bool IsValidSlotIndex(int32 Index) const { return Index >= 0 && Index < GetTotalInventorySlotCount(); }
+
+	/** Add a predicted stack for a slot on top of the replicated one. */
+	void PredictSlot(int32 SlotIndex, const FInventoryItemStack& Stack, int32 PredictionKey);
+
+	/** Drop predictions that the replicated slots have caught up with or that the server never answered. */
+	void PrunePredictions();
 
 	/* Is this method necessary since we only call this internally?
 	UFUNCTION(Server, Unreliable, WithValidation)
@@ -105,9 +530,20 @@ private:
 
 public:
 
-	/** Get the characters inventory. */
+	/** Get the characters inventory. The live slots, only read them on the game thread. (other threads use GetSnapshot) */
 	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory Component")
-	FORCEINLINE TArray<FInventoryItemStack>& GetInventoryItems() { return m_InventoryItems; }
+	FORCEINLINE const TArray<FInventoryItemStack>& GetInventoryItems() const { return m_InventoryItems; }
+
+	/**
+	 * Get the slots as of the end of the last frame they changed in. Safe to call from any thread, the snapshot can be
+	 * held and read for as long as needed without blocking the game thread.
+	 *
+	 * @return The latest snapshot, null until the inventory has published one
+	 */
+	FInventorySnapshotPtr GetSnapshot() const;
+
+	/** Game thread: Publish a snapshot of the slots if they changed since the last one, called by UInventorySubsystem at the end of the frame. */
+	void PublishSnapshot();
 
 	/** Get the actor in the characters view */
 	UFUNCTION(BlueprintCallable, Category = "TRDWLL|Inventory Component")
@@ -143,7 +579,13 @@ public:
 	 * @param const FName & Name The item that you want to get the data of (RowName)
 	 */
 	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory Component")
-	FORCEINLINE FInventoryItem& GetItemData(const FName& Name) { return *GetItemDataTable()->FindRow<FInventoryItem>(Name, ""); }
+	FORCEINLINE const FInventoryItem& GetItemData(const FName& Name)
+	{
+		static const FInventoryItem EmptyItem;
+
+		const FInventoryItem* const Item = FindItemData(Name);
+		return Item ? *Item : EmptyItem;
+	}
 
 	/** Get the inventory rows. */
 	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory Component")
@@ -155,14 +597,18 @@ public:
 
 	/** Get the count of slots that are available in the inventory. */
 	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory Component")
-	FORCEINLINE uint8 GetInventorySlotsCount() const { return m_InventoryRowsNum * m_InventoryColumnsNum; }
+	FORCEINLINE int32 GetInventorySlotsCount() const { return m_InventoryRowsNum * m_InventoryColumnsNum; }
 
 	/** Get the count of slots for the action bar if it's enabled. */
 	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory Component")
 	FORCEINLINE uint8 GetActionBarSlotCount() const { return m_ActionBarSlotsNum; }
 
 	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory Component")
-	FORCEINLINE uint8 GetTotalInventorySlotCount() const { return GetInventorySlotsCount() + GetActionBarSlotCount(); }
+	FORCEINLINE int32 GetTotalInventorySlotCount() const { return GetInventorySlotsCount() + GetActionBarSlotCount(); }
+
+	/** Get the version of a slot. The version changes every time the slot changes so widgets can skip refreshing. */
+	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory Component")
+	FORCEINLINE int32 GetSlotVersion(int32 SlotIndex) const { return m_InventoryItems.IsValidIndex(SlotIndex) ? m_InventoryItems[SlotIndex].Version : INDEX_NONE; }
 
 	/** Called when an item is picked up */
 	UPROPERTY(BlueprintAssignable)
@@ -184,6 +630,55 @@ public:
 	UPROPERTY(BlueprintAssignable)
 	FOnItemExecDelegate OnItemExec;
 
+	/** Called when an item spoils or breaks. */
+	UPROPERTY(BlueprintAssignable)
+	FOnItemExpiredDelegate OnItemExpired;
+
+	/** Called when the instance data of a stack changes. (on the server when it's written and on clients when it's replicated) */
+	UPROPERTY(BlueprintAssignable)
+	FOnInstanceDataChangedDelegate OnInstanceDataChanged;
+
+	/** Called when an item with a cast time starts being used. */
+	UPROPERTY(BlueprintAssignable)
+	FOnItemCastDelegate OnCastStarted;
+
+	/** Called when a cast is interrupted before it finishes. */
+	UPROPERTY(BlueprintAssignable)
+	FOnItemCastDelegate OnCastInterrupted;
+
+	/** Called when a cooldown group can be used again. (server only) */
+	UPROPERTY(BlueprintAssignable)
+	FOnCooldownEndedDelegate OnCooldownEnded;
+
+	/** Called when a recipe becomes craftable or stops being craftable. */
+	UPROPERTY(BlueprintAssignable)
+	FOnCraftableRecipesChangedDelegate OnCraftableRecipesChanged;
+
+	/** Called when a recipe is crafted. */
+	UPROPERTY(BlueprintAssignable)
+	FOnItemCraftedDelegate OnItemCrafted;
+
+	/** Called when the contents of a slot change. (on the server when it's written and on clients when it's replicated) */
+	UPROPERTY(BlueprintAssignable)
+	FOnSlotChangedDelegate OnSlotChanged;
+
+	/** Called once after any number of slots change together. (once per transfer, once per AddItem, once per replication update etc) */
+	UPROPERTY(BlueprintAssignable)
+	FOnInventoryChangedDelegate OnInventoryChanged;
+
+	/** Called when the total weight crosses an encumbrance threshold. (on the server and the owning client) */
+	UPROPERTY(BlueprintAssignable)
+	FOnEncumbranceChangedDelegate OnEncumbranceChanged;
+
+	/**
+	 * Start receiving the slots of a page of a shared stash, replacing the page that was being viewed.
+	 *
+	 * @param UInventoryStashComponent* Stash The stash
+	 * @param int32 Page The page (INDEX_NONE to stop viewing the stash)
+	 */
+	UFUNCTION(BlueprintCallable, Category = "TRDWLL|Inventory Component")
+	void ViewStashPage(class UInventoryStashComponent* Stash, int32 Page = 0);
+
 
 public:
 
@@ -191,9 +686,19 @@ public:
 	 * Add an item to the characters inventory
 	 * 
 	 * @param const FInventoryItemStack & ItemToAdd The item that should be added
+	 * @return How many were added, less than the stack size if the inventory filled up or the weight limit was reached
+	 */
+	UFUNCTION(BlueprintCallable, Category = "TRDWLL|Inventory Component")
+	int32 AddItem(const FInventoryItemStack& ItemToAdd);
+
+	/**
+	 * Add a batch of items by row name, such as the result of rolling a loot table. OnInventoryChanged is only broadcast once.
+	 *
+	 * @param const TArray<FInventoryItemMeta>& Items The items that should be added
+	 * @return How many items were added, less than requested if the inventory filled up
 	 */
 	UFUNCTION(BlueprintCallable, Category = "TRDWLL|Inventory Component")
-	void AddItem(const FInventoryItemStack& ItemToAdd);
+	int32 AddItems(const TArray<FInventoryItemMeta>& Items);
 
 	/*UFUNCTION(BlueprintCallable, Category = "TRDWLL|Inventory Component")
 	void AddItemByID(const FName& Name)
@@ -212,18 +717,545 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "TRDWLL|Inventory Component")
 	FInventoryItemStack RemoveItemBySlot(int32 SlotID);
 
+	/**
+	 * Use the item in a slot
+	 *
+	 * @param int32 SlotIndex The slot of the item that should be used
+	 */
 	UFUNCTION(BlueprintCallable, Category = "TRDWLL|Inventory Component")
-	void ExecItem(const FInventoryItemStack& Item);
+	void ExecItem(int32 SlotIndex);
 
 	UFUNCTION(BlueprintCallable, Category = "TRDWLL|Inventory Component")
 	void SwapItem(int32 CurrentIndex, int32 NewIndex);
 
+	/**
+	 * Move part of a stack into the next empty slot
+	 *
+	 * @param int32 SlotIndex The slot of the stack that should be split
+	 * @param int32 Quantity How many should be moved into the new stack
+	 */
 	UFUNCTION(BlueprintCallable, Category = "TRDWLL|Inventory Component")
-	void SplitItemStack(const FInventoryItemStack& Item, int32 NewStackSize);
+	void SplitItemStack(int32 SlotIndex, int32 Quantity);
 
 	UFUNCTION(BlueprintCallable, Category = "TRDWLL|Inventory Component")
 	void CombineItemStack(int32 ItemToCombine, int32 TargetItem);
 
+	/**
+	 * Merge the partial stacks of every item and sort the inventory slots, done by the server in one go. (the action bar is left alone)
+	 *
+	 * @param EInventorySortKey SortKey What the stacks are ordered by
+	 * @param bool bDescending Should the order be reversed?
+	 */
+	UFUNCTION(BlueprintCallable, Category = "TRDWLL|Inventory Component")
+	void SortAndConsolidate(EInventorySortKey SortKey, bool bDescending = false);
+
+	/**
+	 * Get a slot the way the owning client should see it. (the predicted stack if there is one, else the replicated one)
+	 *
+	 * @param int32 SlotIndex The slot to get
+	 */
+	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory Component")
+	const FInventoryItemStack& GetDisplayedSlot(int32 SlotIndex) const;
+
+protected:
+
+	/** Server: Use the item in a slot, returns false if the slot is empty or changed since the client saw it. */
+	bool ApplyExec(int32 SlotIndex, int32 SlotVersion);
+
+	/** Server: Drop a slot into the world, returns false if there's nothing to drop or it couldn't be spawned. */
+	bool ApplyDrop(int32 ItemIndex, int32 Quantity);
+
+	/** Server: Swap 2 slots, returns false if the move isn't valid. */
+	bool ApplySwap(int32 CurrentIndex, int32 NewIndex);
+
+	/** Server: Move as much of a stack as fits onto another stack of the same item, returns false if nothing moved. */
+	bool ApplyCombine(int32 ItemToCombine, int32 TargetItem);
+
+	/** The slot part of a stack would be split into. */
+	int32 GetSplitSlot(int32 SourceIndex) const;
+
+	/** Server: Move part of a stack into an empty slot, returns false if the split isn't valid. */
+	bool ApplySplit(int32 SourceIndex, int32 TargetIndex, int32 Quantity);
+
+	/** Server: Merge the partial stacks and sort the inventory slots, returns false if the sorted stacks don't fit the grid. */
+	bool ApplySortAndConsolidate(EInventorySortKey SortKey, bool bDescending);
+
+	/** The moves themselves, shared by the server and client prediction so both get the same result. */
+	static bool SwapStacks(FInventoryItemStack& Current, FInventoryItemStack& New);
+	static bool CombineStacks(FInventoryItemStack& Source, FInventoryItemStack& Target, float Now);
+	static bool SplitStacks(FInventoryItemStack& Source, FInventoryItemStack& Target, int32 Quantity);
+
+	/**
+	 * Write a stack into a slot. All slot writes should go through here so the slot version is bumped.
+	 *
+	 * @param int32 Index The slot to write
+	 * @param const FInventoryItemStack& NewStack The stack that should be in the slot
+	 */
+	void SetSlot(int32 Index, const FInventoryItemStack& NewStack);
+
+	/** Server: Craft a recipe, either everything happens or nothing does. */
+	bool ApplyCraft(int32 RecipeIndex, int32 Count);
+
+	/**
+	 * Server: Take items out of the inventory, from the last slots first.
+	 *
+	 * @param const FName& ItemID The row name of the item
+	 * @param int32 Quantity How many to take
+	 * @return How many were taken
+	 */
+	int32 ConsumeItem(const FName& ItemID, int32 Quantity);
+
+	/** Re-check the recipes that use the items whose totals changed. */
+	void UpdateCraftableRecipes();
+
+	/** Server: Use the item in a slot now, start its cooldown and wear it. */
+	void CompleteExec(int32 SlotIndex, float Now);
+
+	/** Server: Start using the item in a slot over time. */
+	void StartCast(int32 SlotIndex, float Now);
+
+	/** Server: Stop the current cast, broadcasting OnCastInterrupted. */
+	void InterruptCast();
+
+	/** Server: Work out the encumbrance level from the total weight and broadcast OnEncumbranceChanged if it changed. */
+	void UpdateEncumbrance();
+
+	UFUNCTION()
+	void OnRep_EncumbranceLevel(uint8 OldLevel);
+
+	/** Server: Put the cooldown group of an item on cooldown. */
+	void StartCooldown(const FInventoryItem& Item, float Now);
+
+	/** Remove the cooldowns that have ended. */
+	void PruneCooldowns(float Now);
+
+	/** Rebuild the index into m_Cooldowns. */
+	void RebuildCooldownIndex();
+
+	/** Server: Get the instance data of a slot to modify, giving the stack an instance ID if it doesn't have one. */
+	FInventoryInstanceData* GetOrCreateInstanceData(int32 SlotIndex);
+
+	/** Server: Schedule the slot to be expired when its condition runs out. */
+	void ScheduleExpiry(int32 Index);
+
+	/** Server: Replace the stack in a slot with its expired item, or clear it. */
+	void ExpireSlot(int32 SlotIndex);
+
+	/**
+	 * Server: Replace the stack in a slot with one whose footprint may be different. It stays in the slot if it fits there,
+	 * otherwise it's moved to wherever it fits, and dropped if it fits nowhere.
+	 *
+	 * @param int32 Index The slot to replace
+	 * @param const FInventoryItemStack& NewStack What the slot should hold
+	 * @return False if it fits nowhere and can't be dropped, the slot keeps the stack it had
+	 */
+	bool ReplaceSlot(int32 Index, const FInventoryItemStack& NewStack);
+
+	/** Bump the version of a slot that was modified in place and notify listeners. */
+	virtual void MarkSlotDirty(int32 Index);
+
+	/** Client: Write a slot that was sent outside of property replication. */
+	void ReceiveSlot(int32 Index, const FInventoryItemStack& Stack);
+
+	/** Should the slots replicate to everyone that can see the owner? Shared stashes send pages to their viewers instead. */
+	bool m_bReplicateSlots;
+
+	/** Add a slot to / remove a slot from the stacking index. */
+	void IndexSlot(int32 Index);
+	void UnindexSlot(int32 Index);
+
+	/** Rebuild the stacking index from scratch. (clients rebuild it whenever the slots replicate) */
+	void RebuildSlotIndex();
+
+	/**
+	 * Server: Put as much of a stack into the inventory as fits. Partial stacks of the same item are filled first if it auto stacks.
+	 *
+	 * @param const FInventoryItemStack& Stack The stack to insert
+	 * @return How many were inserted
+	 */
+	int32 InsertStack(const FInventoryItemStack& Stack);
+
+	/** Server: Open/close a change batch, OnInventoryChanged is broadcast once when the outermost batch closes. */
+	void BeginChangeBatch();
+	void EndChangeBatch();
+
+	/** Called from BeginPlay to set up the slots, containers override this to create them on demand. */
+	virtual void InitializeSlots();
+
+	/** Server: Called before the slots are queried or inserted into, containers create them here if they haven't been. */
+	virtual void PrepareSlots() const {}
+
+	/** Create the slot array with every slot empty. */
+	void AllocateSlots();
+
+	/** Free the slot array. */
+	void ReleaseSlots();
+
+	/** The highest slot version when the slots were last freed, new slots start above it so versions never go back. */
+	int32 m_SlotVersionBase;
+
+	/** Server: Called when a slot change adds or takes away some of an item (not when the index is rebuilt). */
+	virtual void OnItemTotalChanged(FName Key, int32 Delta, float WeightDelta) {}
+
+	/** Can bag items go into this inventory? */
+	virtual bool CanHoldBags() const { return true; }
+
+	/** How many of an item fit in the weight that's left, at most Count. */
+	int32 GetCountWithinWeight(const FInventoryItem& Item, int32 Count) const;
+
+	/** Has the slot array been created? */
+	FORCEINLINE bool HasSlots() const { return m_InventoryItems.Num() > 0; }
+
+	/** Look up item data by RowName, nullptr if there's no such row. */
+	const FInventoryItem* FindItemData(const FName& Name);
+
+	/** The last snapshot that was published, only swapped while holding m_SnapshotLock. */
+	FInventorySnapshotPtr m_Snapshot;
+	mutable FCriticalSection m_SnapshotLock;
+
+	/** Have the slots changed since the last snapshot? */
+	bool m_bSnapshotDirty;
+
+	/** The snapshot blocks with a slot that changed since the last snapshot, the rest are shared with it. */
+	TBitArray<> m_DirtySnapshotBlocks;
+
+	/** Does the next snapshot have to copy every block, the slots were rebuilt or resized? */
+	bool m_bSnapshotAllDirty;
+
+	/** Have a slot published at the end of the frame, every slot if Index is INDEX_NONE. */
+	void MarkSnapshotDirty(int32 Index = INDEX_NONE);
+
+public:
+
+	/**
+	 * Server: Send item definitions to the owning client, in parts if there are a lot of them.
+	 *
+	 * @param int32 Version The registry version the definitions are from
+	 * @param const TArray<FInventoryItem>& Items The definitions that changed
+	 * @param const TArray<FName>& RemovedItems The items that no longer have a definition
+	 */
+	void SendItemDefinitions(int32 Version, const TArray<FInventoryItem>& Items, const TArray<FName>& RemovedItems);
+
+protected:
+
+	friend struct FInventoryChangeBatch;
+	friend class UInventoryStashComponent;
+
+public:
+
+	/**
+	 * How many of a stack's item could be inserted right now.
+	 *
+	 * @param const FInventoryItemStack& Stack The stack that would be inserted
+	 */
+	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory Component")
+	int32 GetCapacityFor(const FInventoryItemStack& Stack) const;
+
+	/**
+	 * Server: Move items from a slot into another inventory in one step. Nothing moves if the target can't hold all of them.
+	 *
+	 * @param UInventoryComponent* Target The inventory to move into
+	 * @param int32 SlotIndex The slot to move from
+	 * @param int32 Quantity How many to move (0 for the whole slot)
+	 * @return True if the items were moved
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "TRDWLL|Inventory Component")
+	bool TransferItem(UInventoryComponent* Target, int32 SlotIndex, int32 Quantity = 0);
+
+	/**
+	 * Server: Move every slot that fits into another inventory.
+	 *
+	 * @param UInventoryComponent* Target The inventory to move into
+	 * @return How many slots were moved
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "TRDWLL|Inventory Component")
+	int32 TransferAll(UInventoryComponent* Target);
+
+	/**
+	 * Server: Move every slot that passes the filter and fits into another inventory.
+	 *
+	 * @param UInventoryComponent* Target The inventory to move into
+	 * @param FInventoryItemFilter Filter Return true for the items that should be moved
+	 * @return How many slots were moved
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "TRDWLL|Inventory Component")
+	int32 TransferByFilter(UInventoryComponent* Target, FInventoryItemFilter Filter);
+
+	/** Get the instance data by instance ID, nullptr if the instance has none. */
+	const FInventoryInstanceData* FindInstanceData(int32 InstanceID) const;
+
+	/**
+	 * Get the instance data of the stack in a slot.
+	 *
+	 * @param int32 SlotIndex The slot of the stack
+	 * @param FInventoryInstanceData& OutData The instance data
+	 * @return False if the stack has no instance data
+	 */
+	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory Component")
+	bool GetInstanceData(int32 SlotIndex, FInventoryInstanceData& OutData) const;
+
+	/**
+	 * Get a property of the stack in a slot.
+	 *
+	 * @param int32 SlotIndex The slot of the stack
+	 * @param FName Name The name of the property
+	 * @param float DefaultValue Returned if the property hasn't been set
+	 */
+	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory Component")
+	float GetInstanceProperty(int32 SlotIndex, FName Name, float DefaultValue = 0.0f) const;
+
+	/**
+	 * Server: Set a property of the stack in a slot. The stack gets instance data the first time, after which it no longer merges or splits.
+	 *
+	 * @param int32 SlotIndex The slot of the stack
+	 * @param FName Name The name of the property
+	 * @param float Value The new value
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "TRDWLL|Inventory Component")
+	void SetInstanceProperty(int32 SlotIndex, FName Name, float Value);
+
+	/** Server: Add a tag (such as an attachment) to the stack in a slot. */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "TRDWLL|Inventory Component")
+	void AddInstanceTag(int32 SlotIndex, FName Tag);
+
+	/** Server: Remove a tag from the stack in a slot. */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "TRDWLL|Inventory Component")
+	void RemoveInstanceTag(int32 SlotIndex, FName Tag);
+
+	/**
+	 * Get how many of an item there are across every slot.
+	 *
+	 * @param FName ItemID The row name of the item
+	 * @param bool bIncludeBags Count what's in the bags in this inventory as well (only known on the server)
+	 */
+	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory Component")
+	int32 GetItemTotal(FName ItemID, bool bIncludeBags = true) const;
+
+	/**
+	 * Find the items in the slots with a word in their title, plural title or description starting with each word of the text.
+	 * Only the items held are checked against the item search index, no item text is looked at.
+	 *
+	 * @param const FString& Text What's being searched for (empty for every item held)
+	 * @return The row names of the items
+	 */
+	UFUNCTION(BlueprintCallable, Category = "TRDWLL|Inventory Component")
+	TArray<FName> SearchItems(const FString& Text) const;
+
+	/**
+	 * Find the slots holding items that match a search, see SearchItems.
+	 *
+	 * @param const FString& Text What's being searched for (empty for every slot that isn't empty)
+	 * @return The slot indexes in order
+	 */
+	UFUNCTION(BlueprintCallable, Category = "TRDWLL|Inventory Component")
+	TArray<int32> GetSlotsMatching(const FString& Text) const;
+
+	/**
+	 * Get the weight of everything in the inventory.
+	 *
+	 * @param bool bIncludeBags Add what's in the bags in this inventory (only known on the server and the owning client)
+	 */
+	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory Component")
+	float GetTotalWeight(bool bIncludeBags = true) const;
+
+	/** Get how much weight the inventory can hold. (0 for no limit) */
+	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory Component")
+	FORCEINLINE float GetMaxWeight() const { return m_MaxWeight; }
+
+	/** Get how much more weight can be put in, MAX_flt if there's no limit. Bags are limited by the inventory they're in as well. */
+	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory Component")
+	virtual float GetWeightLeft() const;
+
+	/** Get how many of the encumbrance thresholds the total weight has reached. */
+	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory Component")
+	FORCEINLINE int32 GetEncumbranceLevel() const { return m_EncumbranceLevel; }
+
+	/**
+	 * Server: Open the bag in a slot, creating its inventory the first time.
+	 *
+	 * @param int32 SlotIndex The slot of the bag
+	 * @return The bag's inventory or nullptr if the slot doesn't hold a bag
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "TRDWLL|Inventory Component")
+	class UInventoryBagComponent* OpenBag(int32 SlotIndex);
+
+	/** Server: Close the bag in a slot that was opened with OpenBag. */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "TRDWLL|Inventory Component")
+	void CloseBag(int32 SlotIndex);
+
+	/** Get the inventory of the bag in a slot, nullptr if it's never been opened. */
+	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory Component")
+	class UInventoryBagComponent* GetBag(int32 SlotIndex) const;
+
+	/** Server: Called by the bags in this inventory when their contents change. */
+	void AddBagContents(FName Key, int32 Delta, float WeightDelta);
+
+	/**
+	 * Would a stack fit with its top left corner in a slot? Always true for empty slots when not using footprints.
+	 *
+	 * @param int32 SlotIndex The slot
+	 * @param const FInventoryItemStack& Stack The stack
+	 */
+	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory Component")
+	bool CanPlaceAt(int32 SlotIndex, const FInventoryItemStack& Stack) const;
+
+	/** Are there enough items to craft a recipe? */
+	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory Component")
+	bool CanCraft(const class UInventoryRecipe* Recipe) const;
+
+	/** Get every recipe that can be crafted right now. */
+	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory Component")
+	TArray<class UInventoryRecipe*> GetCraftableRecipes() const;
+
+	/**
+	 * Craft a recipe, using up its inputs and adding its outputs in one step. Nothing changes if the outputs don't fit.
+	 *
+	 * @param UInventoryRecipe* Recipe The recipe to craft
+	 * @param int32 Count How many times to craft it (at most 1000)
+	 */
+	UFUNCTION(BlueprintCallable, Category = "TRDWLL|Inventory Component")
+	void CraftRecipe(class UInventoryRecipe* Recipe, int32 Count = 1);
+
+	/** Server: Called by the inventory subsystem when a timer scheduled by this inventory comes up. */
+	void OnInventoryTimer(EInventoryTimer Type, int32 SlotIndex, int32 Key);
+
+	/**
+	 * Can the item in a slot be used right now? (it isn't on cooldown and nothing is being cast)
+	 *
+	 * @param int32 SlotIndex The slot of the item
+	 */
+	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory Component")
+	bool IsItemReady(int32 SlotIndex) const;
+
+	/**
+	 * Get how many seconds are left on a cooldown group.
+	 *
+	 * @param FName CooldownGroup The group (the item's row name if it doesn't have a group)
+	 */
+	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory Component")
+	float GetCooldownRemaining(FName CooldownGroup) const;
+
+	/** Is an item being used over time? */
+	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory Component")
+	FORCEINLINE bool IsCasting() const { return m_ActiveCast.SlotIndex != INDEX_NONE; }
+
+	/** Get the item being used over time. */
+	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory Component")
+	FORCEINLINE FInventoryCast GetActiveCast() const { return m_ActiveCast; }
+
+	/** Interrupt the item being used over time. */
+	UFUNCTION(BlueprintCallable, Category = "TRDWLL|Inventory Component")
+	void CancelCast();
+
+	/** Get the time conditions are worked out with. (the server's world time, on clients too) */
+	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory Component")
+	float GetInventoryTime() const;
+
+	/**
+	 * Get the condition of a slot right now. (1 is fresh/new, 0 is spoiled/broken)
+	 *
+	 * @param int32 SlotIndex The slot to get the condition of
+	 */
+	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory Component")
+	float GetSlotCondition(int32 SlotIndex) const;
+
+	/** Server: Native version of TransferByFilter. */
+	int32 TransferByFilter(UInventoryComponent* Target, TFunctionRef<bool(const FInventoryItemStack&)> Filter);
+
+	/**
+	 * Server: Write a list of slot changes in a single change batch. Stacks go through ReplaceSlot so a changed footprint is moved
+	 * or dropped rather than overlapping another one.
+	 *
+	 * @param const TArray<TPair<int32, FInventoryItemStack>>& Changes The slot index and new stack of each change
+	 * @return How many slots were written (a stack kept because it had nowhere to go isn't counted)
+	 */
+	int32 ApplySlotChanges(const TArray<TPair<int32, FInventoryItemStack>>& Changes);
+
+protected:
+
+	/** The grid cells taken by item footprints. (only when using footprints) */
+	FInventoryGrid m_Grid;
+
+	/** Is the slot part of the footprint grid? */
+	FORCEINLINE bool IsGridSlot(int32 Index) const { return m_bUseFootprints && Index >= 0 && Index < GetInventorySlotsCount(); }
+
+	/** Mark the cells a stack takes up from a slot as taken or free. */
+	void MarkFootprint(FInventoryGrid& Grid, int32 Index, const FInventoryItemStack& Stack, bool bTaken) const;
+
+	/**
+	 * Would stacks fit into slots once other slots are emptied? Slots outside the grid always fit if they're empty.
+	 *
+	 * @param const TArray<TPair<int32, FInventoryItemStack>>& Placements The slot and stack of each placement, checked in order
+	 * @param int32 IgnoreA/IgnoreB Slots whose stacks are treated as gone (INDEX_NONE for none)
+	 */
+	bool FitsInGrid(const TArray<TPair<int32, FInventoryItemStack>>& Placements, int32 IgnoreA = INDEX_NONE, int32 IgnoreB = INDEX_NONE) const;
+
+	/**
+	 * Find a slot a stack can go into. With footprints this is the first place in the grid it fits, turning it if needed, then the action bar.
+	 *
+	 * @param FInventoryItemStack& Stack The stack, turned if it only fits sideways
+	 * @return The slot or INDEX_NONE if it doesn't fit anywhere
+	 */
+	int32 FindSlotFor(FInventoryItemStack& Stack) const;
+
+	/** How many of each item there are, by item key. */
+	TMap<FName, int32> m_ItemTotals;
+
+	/** Items whose totals changed since the craftable recipes were last updated. */
+	TSet<FName> m_DirtyTotals;
+
+	/** Which recipes can be crafted right now, indexed like the crafting subsystem's recipes. */
+	TBitArray<> m_CraftableRecipes;
+
+	class UInventoryCraftingSubsystem* m_CraftingSubsystem;
+
+	/** Where item data is looked up, the baked item database or the DataTable. */
+	class UInventoryItemSubsystem* m_ItemSubsystem;
+
+	/** Slots holding a stack that isn't full, by item key. */
+	TMap<FName, TArray<int32>> m_PartialStacks;
+
+	/** How many slots are empty. */
+	int32 m_EmptySlotCount;
+
+	/** The weight of every stack in the slots. */
+	float m_TotalWeight;
+
+	/** Server: The bags in this inventory that have been opened, by the instance ID of their stack. */
+	UPROPERTY(Transient)
+	TMap<int32, class UInventoryBagComponent*> m_Bags;
+
+	/** Server: The totals of everything in the bags. */
+	TMap<FName, int32> m_BagTotals;
+
+	/** The weight of everything in the bags. (replicated to the owner so it can show the full weight) */
+	UPROPERTY(Replicated)
+	float m_BagWeight;
+
+	/** How many of m_EncumbranceThresholds the total weight has reached. */
+	UPROPERTY(ReplicatedUsing = OnRep_EncumbranceLevel)
+	uint8 m_EncumbranceLevel;
+
+	/** Server: Create the inventory of a bag. */
+	class UInventoryBagComponent* CreateBag(int32 InstanceID, int32 Slots);
+
+	/** Server: Destroy the inventory of a bag whose contents have already been moved somewhere else, along with what's in it. */
+	void DestroyBag(int32 InstanceID);
+
+	/**
+	 * Server: Destroy the inventory of a bag that left the inventory without its contents, putting them back into the inventory and dropping what doesn't fit.
+	 *
+	 * @return False if some of the contents couldn't be put back or dropped, they stay in the bag and the bag is kept
+	 */
+	bool SpillBag(int32 InstanceID);
+
+	/** Server: Does the stack in a slot have a bag with anything in it? */
+	bool HasBagContents(int32 SlotIndex) const;
+
+	/** Server: How many change batches are open and whether anything changed in them. */
+	int32 m_ChangeBatchDepth;
+	bool m_bChangedInBatch;
+
 	/** Helper functions */
 public:
 	
@@ -246,8 +1278,13 @@ public:
 	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory Componet")
 	int32 GetNextEmptySlot();
 
+	/** Is there room for a stack that takes 1 slot? (with footprints, bigger items may still not fit, see CanHoldItem) */
+	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory Component")
+	bool HasEmptySlot() const;
+
+	/** Can any of a stack be added? Counts the room left on partial stacks, where its footprint fits and the weight limit. */
 	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory Component")
-	bool HasEmptySlot() { return GetNextEmptySlot() > -1; }
+	FORCEINLINE bool CanHoldItem(const FInventoryItemStack& Stack) const { return GetCapacityFor(Stack) > 0; }
 
 	int32 GetItemIndex(const FInventoryItemStack& Item)
 	{
@@ -262,13 +1299,11 @@ public:
 		return -1;
 	}
 
-	// TODO: implement a better way to determine if the inventory is full or not as this isn't 100% reliable
-	// This doesn't allow you to pick up more items if the slot isn't full (ie full on items, but item 0 is 1 when it can stack to 2)
+	/** Is there no room for anything at all? Whether a particular item fits is CanHoldItem. */
 	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory Component")
-	FORCEINLINE bool IsInventoryFull() 
+	FORCEINLINE bool IsInventoryFull() const
 	{ 
-		// TODO: check if all slots are full and those slots are stacked to the max and if the slots aren't empty
-		return !HasEmptySlot();
+		return (!HasEmptySlot() && m_PartialStacks.Num() == 0) || GetWeightLeft() <= 0.0f;
 	}
 
 public:
@@ -296,3 +1331,26 @@ public:
 	}
 
 };
+
+/** Groups slot changes so OnInventoryChanged is only broadcast once for all of them. */
+struct FInventoryChangeBatch
+{
+	explicit FInventoryChangeBatch(UInventoryComponent* InInventory) : Inventory(InInventory)
+	{
+		if (Inventory)
+		{
+			Inventory->BeginChangeBatch();
+		}
+	}
+
+	~FInventoryChangeBatch()
+	{
+		if (Inventory)
+		{
+			Inventory->EndChangeBatch();
+		}
+	}
+
+private:
+	UInventoryComponent* Inventory;
+};
@@ -0,0 +1,109 @@
+/**
+ * Copyright 2019-2020 - Russ 'trdwll' Treadwell https://trdwll.com
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "InventoryComponent.h"
+#include "InventorySystem.h"
+
+#include "InventoryContainerComponent.generated.h"
+
+/**
+ * An inventory for chests, corpses etc. The slots aren't created until someone opens or queries the container
+ * and they're released again after it hasn't been used for a while, so placing thousands of them is cheap.
+ */
+UCLASS(ClassGroup=(TRDWLL), meta=(BlueprintSpawnableComponent))
+class INVENTORYPLUGIN_API UInventoryContainerComponent : public UInventoryComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	UInventoryContainerComponent();
+
+protected:
+
+	virtual void InitializeSlots() override;
+	virtual void PrepareSlots() const override;
+
+	/** The items that are put into the container the first time it's opened. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "TRDWLL|Inventory Container", meta = (DisplayName = "Loot"))
+	TArray<FInventoryItemMeta> m_Loot;
+
+	/** A loot table rolled on top of m_Loot the first time the container is opened. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "TRDWLL|Inventory Container", meta = (DisplayName = "Loot Table"))
+	class UInventoryLootTable* m_LootTable;
+
+	/** The seed for the loot table. (0 for a random seed) */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "TRDWLL|Inventory Container", meta = (DisplayName = "Loot Seed"))
+	int32 m_LootSeed;
+
+	/** How long the container has to go unused before its slots are released. (0 to never release them) */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "TRDWLL|Inventory Container", meta = (ClampMin = "0", DisplayName = "Release Delay"))
+	float m_ReleaseDelay;
+
+	/**
+	 * Generate the contents of the container, called the first time the slots are created.
+	 * By default this adds m_Loot and rolls m_LootTable, override it to roll your own loot.
+	 *
+	 * @param TArray<FInventoryItemMeta>& OutContents The items that should go in the container
+	 */
+	UFUNCTION(BlueprintNativeEvent, Category = "TRDWLL|Inventory Container")
+	void GenerateContents(TArray<FInventoryItemMeta>& OutContents);
+
+	/** Are the stored contents being put back into the slots? (they were already in the container, so nothing was really added) */
+	FORCEINLINE bool IsRestoring() const { return m_bRestoring; }
+
+private:
+
+	/** The contents as row names and quantities while the slots are released. */
+	TArray<FInventoryItemMeta> m_StoredContents;
+
+	/** Have the contents been generated yet? */
+	bool m_bGenerated;
+
+	/** How many viewers have the container open. */
+	int32 m_OpenCount;
+
+	bool m_bRestoring;
+
+	/** Are the slots being created and filled? (they're queried while they're filled) */
+	bool m_bMaterializing;
+
+	FTimerHandle m_ReleaseTimer;
+
+	/** Start counting down to releasing the slots. */
+	void ScheduleRelease();
+
+	/** Store the contents compactly and free the slots. Containers holding a stack with instance data (a bag etc) stay materialized, see ExportContents. */
+	void Dehydrate();
+
+public:
+
+	/** Server: Create the slots and fill them if they haven't been yet. The queries and inserts of the inventory call this themselves. */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "TRDWLL|Inventory Container")
+	void EnsureMaterialized();
+
+	/** Server: Called when a viewer opens the container, keeps the slots around until it's closed. */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "TRDWLL|Inventory Container")
+	void OpenContainer();
+
+	/** Server: Called when a viewer closes the container. */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "TRDWLL|Inventory Container")
+	void CloseContainer();
+
+	/**
+	 * Get the contents as row names and quantities, whether the slots are created or not.
+	 *
+	 * @param TArray<FInventoryItemMeta>& OutContents The contents
+	 * @return False if a stack has state the compact form can't hold (condition, instance data, so any bag)
+	 */
+	bool ExportContents(TArray<FInventoryItemMeta>& OutContents) const;
+
+	/** Are the slots currently created? */
+	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory Container")
+	FORCEINLINE bool IsMaterialized() const { return HasSlots(); }
+};
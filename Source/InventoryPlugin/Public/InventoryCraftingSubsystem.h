@@ -0,0 +1,44 @@
+/**
+ * Copyright 2019-2020 - Russ 'trdwll' Treadwell https://trdwll.com
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+
+#include "InventoryCraftingSubsystem.generated.h"
+
+/**
+ * Keeps the recipes from the plugin settings and which recipes use each item, so inventories only look at the recipes an item change can affect.
+ */
+UCLASS()
+class INVENTORYPLUGIN_API UInventoryCraftingSubsystem final : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+	/** Every recipe, an inventory's craftable bits are indexed the same way. */
+	UPROPERTY()
+	TArray<class UInventoryRecipe*> m_Recipes;
+
+	/** The recipes that use each item as an input, by row name. */
+	TMap<FName, TArray<int32>> m_RecipesByInput;
+
+public:
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/** Get every recipe. */
+	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory System")
+	FORCEINLINE TArray<class UInventoryRecipe*> GetRecipes() const { return m_Recipes; }
+
+	FORCEINLINE int32 GetRecipeCount() const { return m_Recipes.Num(); }
+	FORCEINLINE class UInventoryRecipe* GetRecipe(int32 Index) const { return m_Recipes.IsValidIndex(Index) ? m_Recipes[Index] : nullptr; }
+
+	/** Get the index of a recipe, INDEX_NONE if it isn't in the plugin settings. */
+	FORCEINLINE int32 GetRecipeIndex(const class UInventoryRecipe* Recipe) const { return m_Recipes.IndexOfByKey(Recipe); }
+
+	/** Get the recipes that use an item, nullptr if none do. */
+	FORCEINLINE const TArray<int32>* GetRecipesUsing(const FName& ItemID) const { return m_RecipesByInput.Find(ItemID); }
+};
@@ -0,0 +1,122 @@
+/**
+ * Copyright 2019-2020 - Russ 'trdwll' Treadwell https://trdwll.com
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Which cells of an inventory grid are taken, one 64 bit mask per row so checking if an item fits is a shift and a mask per row it covers.
+ * Grids can be at most 64 columns wide.
+ */
+struct FInventoryGrid
+{
+	static const int32 MaxColumns = 64;
+
+	FInventoryGrid() : m_Columns(0) {}
+
+	/** Clear the grid and set its size. */
+	void Reset(int32 Rows, int32 Columns)
+	{
+		m_Columns = FMath::Clamp(Columns, 0, MaxColumns);
+		m_Rows.Init(0, FMath::Max(Rows, 0));
+	}
+
+	FORCEINLINE int32 GetRows() const { return m_Rows.Num(); }
+	FORCEINLINE int32 GetColumns() const { return m_Columns; }
+
+	/** Is the area inside the grid and free? */
+	bool Fits(int32 Row, int32 Column, int32 Width, int32 Height) const
+	{
+		if (Row < 0 || Column < 0 || Width <= 0 || Height <= 0 || Row + Height > m_Rows.Num() || Column + Width > m_Columns)
+		{
+			return false;
+		}
+
+		const uint64 Mask = RowMask(Width) << Column;
+
+		for (int32 i = Row; i < Row + Height; i++)
+		{
+			if (m_Rows[i] & Mask)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	/** Mark an area as taken or free, clipped to the grid. */
+	void Set(int32 Row, int32 Column, int32 Width, int32 Height, bool bTaken)
+	{
+		if (Column < 0 || Column >= m_Columns || Row >= m_Rows.Num())
+		{
+			return;
+		}
+
+		Width = FMath::Min(Width, m_Columns - Column);
+		const uint64 Mask = RowMask(Width) << Column;
+
+		for (int32 i = FMath::Max(Row, 0); i < FMath::Min(Row + Height, m_Rows.Num()); i++)
+		{
+			m_Rows[i] = bTaken ? (m_Rows[i] | Mask) : (m_Rows[i] & ~Mask);
+		}
+	}
+
+	/**
+	 * Find the first free area, top to bottom then left to right.
+	 * Every row is checked for all columns at once: the rows the area would cover are OR'd together and the free bits are AND'd with
+	 * themselves shifted once per extra column, which leaves a bit set at every column the area fits from.
+	 *
+	 * @return False if it doesn't fit anywhere
+	 */
+	bool FindFirstFit(int32 Width, int32 Height, int32& OutRow, int32& OutColumn) const
+	{
+		if (Width <= 0 || Height <= 0 || Width > m_Columns || Height > m_Rows.Num())
+		{
+			return false;
+		}
+
+		const uint64 ColumnMask = RowMask(m_Columns);
+
+		for (int32 Row = 0; Row + Height <= m_Rows.Num(); Row++)
+		{
+			uint64 Taken = 0;
+			for (int32 i = Row; i < Row + Height; i++)
+			{
+				Taken |= m_Rows[i];
+			}
+
+			// The columns past the edge are 0 so areas that would hang off the edge drop out as well
+			const uint64 Free = ~Taken & ColumnMask;
+
+			uint64 Starts = Free;
+			for (int32 i = 1; i < Width && Starts; i++)
+			{
+				Starts &= Free >> i;
+			}
+
+			if (Starts)
+			{
+				OutRow = Row;
+				OutColumn = (int32)FPlatformMath::CountTrailingZeros64(Starts);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+private:
+
+	/** The taken cells of each row, bit N is column N. */
+	TArray<uint64, TInlineAllocator<16>> m_Rows;
+
+	int32 m_Columns;
+
+	static FORCEINLINE uint64 RowMask(int32 Width)
+	{
+		return Width >= 64 ? ~uint64(0) : ((uint64(1) << Width) - 1);
+	}
+};
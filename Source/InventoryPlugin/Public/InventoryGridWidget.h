@@ -0,0 +1,76 @@
+/**
+ * Copyright 2019-2020 - Russ 'trdwll' Treadwell https://trdwll.com
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Blueprint/UserWidget.h"
+
+#include "InventoryComponent.h"
+#include "InventorySlotWidget.h"
+
+#include "InventoryGridWidget.generated.h"
+
+/**
+ * A virtualized grid of inventory slots. Only enough slot widgets to fill the visible rows are created
+ * and they get pointed at different slots as the grid is scrolled, so big stashes cost the same as small bags.
+ */
+UCLASS()
+class INVENTORYPLUGIN_API UInventoryGridWidget final : public UUserWidget
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** The panel the pooled slot widgets are added to. (must be named SlotGrid in the widget blueprint) */
+	UPROPERTY(BlueprintReadOnly, Category = "Settings", meta = (BindWidget))
+	class UUniformGridPanel* SlotGrid;
+
+	/** The widget that's created for each visible slot. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Settings", meta = (DisplayName = "Slot Widget Class"))
+	TSubclassOf<UInventorySlotWidget> m_SlotWidgetClass;
+
+	/** How many rows are visible at once. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Settings", meta = (ClampMin = "1", DisplayName = "Visible Rows"))
+	int32 m_VisibleRows;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Settings", meta = (ExposeOnSpawn = true, DisplayName = "Inventory Component"))
+	UInventoryComponent* m_Inventory;
+
+	/** The row that's shown at the top of the grid. */
+	UPROPERTY(BlueprintReadOnly, Category = "TRDWLL|Inventory System", meta = (DisplayName = "First Visible Row"))
+	int32 m_FirstVisibleRow;
+
+	/** The recycled slot widgets, row major. */
+	UPROPERTY()
+	TArray<UInventorySlotWidget*> m_SlotPool;
+
+	virtual void NativeConstruct() override;
+	virtual FReply NativeOnMouseWheel(const FGeometry& InGeometry, const FPointerEvent& InMouseEvent) override;
+
+	/** Create the pooled slot widgets if the pool doesn't match the visible size. */
+	void BuildPool();
+
+	/** Point each pooled widget at the slot it should show for the current scroll position. */
+	void AssignSlots();
+
+public:
+
+	UInventoryGridWidget(const FObjectInitializer& ObjectInitializer);
+
+	/** Show a different inventory in the grid. */
+	UFUNCTION(BlueprintCallable, Category = "TRDWLL|Inventory System")
+	void SetInventory(UInventoryComponent* Inventory);
+
+	/** Scroll so the given row is at the top of the grid. */
+	UFUNCTION(BlueprintCallable, Category = "TRDWLL|Inventory System")
+	void ScrollToRow(int32 Row);
+
+	/** Get the number of rows in the inventory (not just the visible ones). */
+	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory System")
+	int32 GetTotalRows() const;
+
+	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory System")
+	FORCEINLINE int32 GetFirstVisibleRow() const { return m_FirstVisibleRow; }
+};
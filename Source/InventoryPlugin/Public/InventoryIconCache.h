@@ -0,0 +1,70 @@
+/**
+ * Copyright 2019-2020 - Russ 'trdwll' Treadwell https://trdwll.com
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Containers/List.h"
+
+#include "InventoryIconCache.generated.h"
+
+DECLARE_DELEGATE_OneParam(FOnInventoryIconLoaded, class UTexture2D*);
+
+/**
+ * Streams item icons in on demand and keeps the most recently used ones loaded.
+ * Icons that fall off the end of the cache are released and can be garbage collected.
+ */
+UCLASS()
+class INVENTORYPLUGIN_API UInventoryIconCache final : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+	/** The loaded icons, keeps them from being garbage collected while they're cached. */
+	UPROPERTY()
+	TMap<FSoftObjectPath, class UTexture2D*> m_Icons;
+
+	/** The placeholder that's shown until an icon has loaded. */
+	UPROPERTY()
+	class UTexture2D* m_Placeholder;
+
+	/** Icon paths ordered by use, most recent at the head. */
+	TDoubleLinkedList<FSoftObjectPath> m_LRU;
+	TMap<FSoftObjectPath, TDoubleLinkedList<FSoftObjectPath>::TDoubleLinkedListNode*> m_LRUNodes;
+
+	/** Callbacks waiting on an icon that's currently streaming. */
+	TMap<FSoftObjectPath, TArray<FOnInventoryIconLoaded>> m_PendingLoads;
+
+	int32 m_MaxIcons;
+
+	void OnIconLoaded(FSoftObjectPath Path);
+
+	/** Move an icon to the front of the LRU list, adding it if it isn't there. */
+	void Touch(const FSoftObjectPath& Path);
+
+	/** Release the least recently used icons until the cache fits. */
+	void Trim();
+
+public:
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/**
+	 * Get an icon, streaming it in if it isn't loaded yet.
+	 *
+	 * @param const TSoftObjectPtr<UTexture2D>& Icon The icon to get
+	 * @param FOnInventoryIconLoaded OnLoaded Called once the icon has loaded if it wasn't already
+	 * @return The icon if it's loaded, else the placeholder
+	 */
+	class UTexture2D* RequestIcon(const TSoftObjectPtr<class UTexture2D>& Icon, FOnInventoryIconLoaded OnLoaded = FOnInventoryIconLoaded());
+
+	/** Get the icon that's shown while the real one is loading. */
+	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory System")
+	FORCEINLINE class UTexture2D* GetPlaceholderIcon() const { return m_Placeholder; }
+
+	/** Get how many icons are currently cached. */
+	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory System")
+	FORCEINLINE int32 GetCachedIconCount() const { return m_Icons.Num(); }
+};
@@ -0,0 +1,112 @@
+/**
+ * Copyright 2019-2020 - Russ 'trdwll' Treadwell https://trdwll.com
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/NetSerialization.h"
+
+#include "InventoryInstanceData.generated.h"
+
+/** A named value on an item instance. (ammo, durability, charge etc) */
+USTRUCT(BlueprintType)
+struct FInventoryInstanceProperty
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Inventory System")
+	FName Name;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Inventory System")
+	float Value;
+
+	FInventoryInstanceProperty() : Value(0.0f) {}
+	FInventoryInstanceProperty(const FName& name, float value) : Name(name), Value(value) {}
+};
+
+/** The data of a single item instance, only created once an item has something that differs from its definition. */
+USTRUCT(BlueprintType)
+struct FInventoryInstanceData : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	/** The instance ID of the stack this belongs to. */
+	UPROPERTY(BlueprintReadOnly, Category = "Inventory System")
+	int32 InstanceID;
+
+	/** Named values such as ammo in the magazine. */
+	UPROPERTY(BlueprintReadOnly, Category = "Inventory System")
+	TArray<FInventoryInstanceProperty> Properties;
+
+	/** Tags such as the row names of attachments. */
+	UPROPERTY(BlueprintReadOnly, Category = "Inventory System")
+	TArray<FName> Tags;
+
+	FInventoryInstanceData() : InstanceID(0) {}
+	explicit FInventoryInstanceData(int32 instanceID) : InstanceID(instanceID) {}
+
+	/** Get a property, nullptr if it hasn't been set. */
+	const FInventoryInstanceProperty* FindProperty(const FName& Name) const
+	{
+		return Properties.FindByPredicate([&Name](const FInventoryInstanceProperty& Property) { return Property.Name == Name; });
+	}
+
+	FInventoryInstanceProperty* FindProperty(const FName& Name)
+	{
+		return Properties.FindByPredicate([&Name](const FInventoryInstanceProperty& Property) { return Property.Name == Name; });
+	}
+
+	void PreReplicatedRemove(const struct FInventoryInstanceDataArray& InArraySerializer);
+	void PostReplicatedAdd(const struct FInventoryInstanceDataArray& InArraySerializer);
+	void PostReplicatedChange(const struct FInventoryInstanceDataArray& InArraySerializer);
+};
+
+/** The instance data of an inventory, replicated separately from the slots and only for the instances that changed. */
+USTRUCT()
+struct FInventoryInstanceDataArray : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FInventoryInstanceData> Items;
+
+	/** The inventory this belongs to, told when instances replicate. */
+	class UInventoryComponent* Owner;
+
+	FInventoryInstanceDataArray() : Owner(nullptr), bIndexDirty(false) {}
+
+	/** Get the data of an instance, nullptr if it has none. */
+	const FInventoryInstanceData* Find(int32 InstanceID) const;
+	FInventoryInstanceData* Find(int32 InstanceID) { return const_cast<FInventoryInstanceData*>(static_cast<const FInventoryInstanceDataArray*>(this)->Find(InstanceID)); }
+
+	/** Server: Get the data of an instance to modify, created if it has none. Call MarkItemDirty on it after. */
+	FInventoryInstanceData& FindOrAdd(int32 InstanceID);
+
+	/** Server: Remove the data of an instance. */
+	void Remove(int32 InstanceID);
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FInventoryInstanceData, FInventoryInstanceDataArray>(Items, DeltaParms, *this);
+	}
+
+private:
+
+	/** Index into Items by instance ID, rebuilt lazily after replication moves things around. */
+	mutable TMap<int32, int32> IndexByID;
+	mutable bool bIndexDirty;
+
+	void RebuildIndex() const;
+
+	friend struct FInventoryInstanceData;
+};
+
+template<>
+struct TStructOpsTypeTraits<FInventoryInstanceDataArray> : public TStructOpsTypeTraitsBase2<FInventoryInstanceDataArray>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
@@ -0,0 +1,96 @@
+/**
+ * Copyright 2019-2020 - Russ 'trdwll' Treadwell https://trdwll.com
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "InventorySystem.h"
+
+/**
+ * Item definitions baked from the item DataTable into one flat blob that's memory mapped and read in place,
+ * so starting up doesn't deserialize a UObject for every row. An item is only turned into an FInventoryItem the first time it's looked up.
+ *
+ * The blob is a header, the records, an index of the records sorted by the hash of their ID and a pool of UTF-8 strings.
+ * Every offset is from the start of the blob so it can be mapped anywhere.
+ */
+class INVENTORYPLUGIN_API FInventoryItemDatabase
+{
+public:
+
+	FInventoryItemDatabase();
+	~FInventoryItemDatabase();
+
+	FInventoryItemDatabase(const FInventoryItemDatabase&) = delete;
+	FInventoryItemDatabase& operator=(const FInventoryItemDatabase&) = delete;
+
+	/**
+	 * Map a baked database, falling back to reading it into memory if the platform can't map files.
+	 *
+	 * @param const FString& Filename The file written by the InventoryItemDatabase commandlet
+	 * @return False if the file is missing or isn't a database this version can read
+	 */
+	bool Load(const FString& Filename);
+
+	void Unload();
+
+	FORCEINLINE bool IsLoaded() const { return m_Data != nullptr; }
+
+	/** How many items are in the database. */
+	int32 Num() const;
+
+	/** Get an item by its row name, nullptr if there's no such item. The pointer stays valid until the database is unloaded. */
+	const FInventoryItem* FindItem(const FName& ID);
+
+	/** Read the text of every item straight from the string pool without looking the items up. */
+	void ForEachItemText(TFunctionRef<void(const FName& ID, const FString& Title, const FString& PluralTitle, const FString& Description)> Callback) const;
+
+	/** Get a hash of everything about an item, to tell which items changed between 2 databases without looking them up. */
+	bool GetItemHash(const FName& ID, uint32& OutHash) const;
+
+	/** Get the hash of every item, see GetItemHash. */
+	void ForEachItemHash(TFunctionRef<void(const FName& ID, uint32 Hash)> Callback) const;
+
+	/**
+	 * Bake the rows of an item DataTable.
+	 *
+	 * @param const UDataTable& Table A DataTable of FInventoryItem rows
+	 * @param TArray<uint8>& OutBlob The database
+	 * @return False if the DataTable doesn't hold items
+	 */
+	static bool Write(const class UDataTable& Table, TArray<uint8>& OutBlob);
+
+	/** Get the full path of the database file set in the plugin settings. */
+	static FString GetDatabaseFilename();
+
+private:
+
+	struct FHeader;
+	struct FRecord;
+	struct FIndexEntry;
+	struct FStringRef;
+
+	/** The blob, either mapped or in m_LoadedData. */
+	const uint8* m_Data;
+	int64 m_Size;
+
+	TUniquePtr<class IMappedFileHandle> m_MappedFile;
+	TUniquePtr<class IMappedFileRegion> m_MappedRegion;
+
+	TArray<uint8> m_LoadedData;
+
+	/** The items that have been looked up, reserved to the item count up front so pointers to them stay valid. */
+	TMap<FName, FInventoryItem> m_Items;
+
+	/** Check the header and that every offset is inside the blob. */
+	bool Validate() const;
+
+	const FHeader& GetHeader() const;
+	const FRecord* FindRecord(const FName& ID) const;
+	FString GetString(const FStringRef& String) const;
+	uint32 HashRecord(const FRecord& Record) const;
+
+	/** The hash the index is sorted by. */
+	static uint32 HashID(const FString& ID);
+};
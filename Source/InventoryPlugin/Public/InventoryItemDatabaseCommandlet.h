@@ -0,0 +1,26 @@
+/**
+ * Copyright 2019-2020 - Russ 'trdwll' Treadwell https://trdwll.com
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+
+#include "InventoryItemDatabaseCommandlet.generated.h"
+
+/**
+ * Bakes the item DataTable from the plugin settings into the item database. Run it before packaging:
+ * UE4Editor-Cmd.exe <Project> -run=InventoryItemDatabase [-Output=<File>]
+ */
+UCLASS()
+class INVENTORYPLUGIN_API UInventoryItemDatabaseCommandlet final : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	UInventoryItemDatabaseCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,140 @@
+/**
+ * Copyright 2019-2020 - Russ 'trdwll' Treadwell https://trdwll.com
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Engine/World.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+
+#include "InventorySystem.h"
+#include "InventoryItemDatabase.h"
+#include "InventorySearchIndex.h"
+
+#include "InventoryItemSubsystem.generated.h"
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnItemDefinitionsChanged, const TSet<FName>& /* ItemIDs */);
+
+/**
+ * Where inventories look up item data. Outside of the editor the baked item database is mapped when there is one,
+ * otherwise (and always in the editor, so DataTable edits show up without baking) the item DataTable is used.
+ *
+ * The items can be reloaded while running. The server swaps in the new definitions, bumps the registry version and sends
+ * only the definitions that changed to clients. Slots refer to items by row name on the wire so none of them are resent,
+ * every machine refreshes the copies in its own slots.
+ */
+UCLASS()
+class INVENTORYPLUGIN_API UInventoryItemSubsystem final : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+	/** Swapped for a new one when the items are reloaded. */
+	TUniquePtr<FInventoryItemDatabase> m_Database;
+
+	/** The item DataTable, only loaded when there's no database. */
+	UPROPERTY()
+	class UDataTable* m_DataTable;
+
+	/** The words in the text of every item, built once the items are loaded. */
+	FInventorySearchIndex m_SearchIndex;
+
+	/** Build m_SearchIndex from wherever the items came from. */
+	void BuildSearchIndex();
+
+	/** Bumped every time the definitions change while running. */
+	int32 m_RegistryVersion;
+
+	/** Server: Every item whose definition changed since starting, sent to clients that join later. */
+	TSet<FName> m_ChangedItems;
+
+	/** Client: Definitions sent by the server, used over the local ones. */
+	TMap<FName, FInventoryItem> m_ReceivedItems;
+
+	/** Client: Items the server removed, hidden even though the local definitions still have them. */
+	TSet<FName> m_RemovedItems;
+
+	/** A hash of every DataTable row as of the last load, DataTable rows are edited in place so there's nothing else to compare to. */
+	TMap<FName, uint32> m_RowHashes;
+
+	/** Client: Has an inventory asked the server for the definitions that changed before joining? */
+	bool m_bRequestedDefinitions;
+
+	/** Copies of the DataTable rows with their IDs filled in, so looking an item up never writes to the table. */
+	TMap<FName, FInventoryItem> m_TableItems;
+
+	/** Copy the rows of the DataTable into m_TableItems. */
+	void CopyRows();
+
+	/** Hash the rows of the DataTable. */
+	void HashRows(TMap<FName, uint32>& OutHashes) const;
+
+	/** Swap in a new set of changed definitions and let everything holding copies know. */
+	void CommitChanges(const TSet<FName>& Changed);
+
+	/** Client: Drop what the last server sent so the next one is asked for its own definitions. */
+	void ResetReceivedDefinitions();
+
+	/** A world of this game instance was created, whatever it's connected to is a new session. */
+	void OnPostWorldInitialization(UWorld* World, const UWorld::InitializationValues IVS);
+
+	/** The connection to the server was lost. */
+	void OnNetworkFailure(UWorld* World, UNetDriver* NetDriver, ENetworkFailure::Type FailureType, const FString& ErrorString);
+
+	/** Travelling to another server failed. */
+	void OnTravelFailure(UWorld* World, ETravelFailure::Type FailureType, const FString& ErrorString);
+
+public:
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/** Get an item by its row name, nullptr if there's no such item. Don't hold on to the pointer, it's only valid until the items are reloaded. */
+	const FInventoryItem* FindItem(const FName& ID);
+
+	/** Called with the row names of the items whose definitions changed, inventories refresh the copies in their slots. */
+	FOnItemDefinitionsChanged OnItemDefinitionsChanged;
+
+	/**
+	 * Server: Reload the items from the database file or the DataTable and send the definitions that changed to every client.
+	 *
+	 * @return How many items changed
+	 */
+	UFUNCTION(BlueprintCallable, Category = "TRDWLL|Inventory System")
+	int32 ReloadItems();
+
+	/**
+	 * Client: Use definitions sent by the server in place of the local ones.
+	 *
+	 * @param int32 Version The registry version of the server, older versions are ignored
+	 * @param const TArray<FInventoryItem>& Items The definitions that changed
+	 * @param const TArray<FName>& RemovedItems The items the server no longer has a definition for
+	 */
+	void ApplyDefinitions(int32 Version, const TArray<FInventoryItem>& Items, const TArray<FName>& RemovedItems);
+
+	/** Server: Get the current definitions of every item that changed since starting, and the items that were removed. */
+	void GetChangedDefinitions(TArray<FInventoryItem>& OutItems, TArray<FName>& OutRemovedItems);
+
+	/** Get how many times the definitions have changed since starting. */
+	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory System")
+	FORCEINLINE int32 GetRegistryVersion() const { return m_RegistryVersion; }
+
+	/** Client: True the first time it's called for each server, so only one inventory asks it for the changed definitions. */
+	bool ShouldRequestDefinitions();
+
+	FORCEINLINE const FInventorySearchIndex& GetSearchIndex() const { return m_SearchIndex; }
+
+	/**
+	 * Find every item with a word in its title, plural title or description starting with each word of the text. (for vendors etc)
+	 *
+	 * @param const FString& Text What's being searched for
+	 * @return The row names of the items, nothing if the text has no words
+	 */
+	UFUNCTION(BlueprintCallable, Category = "TRDWLL|Inventory System")
+	TArray<FName> SearchItems(const FString& Text) const;
+
+	/** Are items coming from the baked database? */
+	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory System")
+	FORCEINLINE bool IsUsingItemDatabase() const { return m_Database.IsValid() && m_Database->IsLoaded(); }
+};
@@ -0,0 +1,125 @@
+/**
+ * Copyright 2019-2020 - Russ 'trdwll' Treadwell https://trdwll.com
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+
+#include "InventorySystem.h"
+
+#include "InventoryLootTable.generated.h"
+
+USTRUCT(BlueprintType)
+struct FLootTableEntry
+{
+	GENERATED_BODY()
+
+	/** The item to drop. (leave empty along with NestedTable for a chance of dropping nothing) */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Inventory System")
+	FName ItemRowName;
+
+	/** Roll another table instead of dropping an item. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Inventory System")
+	class UInventoryLootTable* NestedTable;
+
+	/** How likely this entry is compared to the others in the table. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Inventory System", meta = (ClampMin = "0"))
+	float Weight;
+
+	/** How many of the item drop. (for nested tables how many times it's rolled) */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Inventory System", meta = (ClampMin = "1"))
+	int32 MinQuantity;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Inventory System", meta = (ClampMin = "1"))
+	int32 MaxQuantity;
+
+	FLootTableEntry() : NestedTable(nullptr), Weight(1.0f), MinQuantity(1), MaxQuantity(1) {}
+};
+
+/**
+ * A weighted table of items. The weights are compiled into an alias table when the asset loads so every roll costs the same no matter how big the table is.
+ */
+UCLASS(BlueprintType)
+class INVENTORYPLUGIN_API UInventoryLootTable : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+
+	UInventoryLootTable();
+
+	virtual void PostLoad() override;
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+protected:
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "TRDWLL|Loot Table", meta = (DisplayName = "Entries"))
+	TArray<FLootTableEntry> m_Entries;
+
+	/** How many times the table is rolled. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "TRDWLL|Loot Table", meta = (ClampMin = "0", DisplayName = "Min Rolls"))
+	int32 m_MinRolls;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "TRDWLL|Loot Table", meta = (ClampMin = "0", DisplayName = "Max Rolls"))
+	int32 m_MaxRolls;
+
+private:
+
+	/** The alias table, entry i is picked if a uniform roll is under m_Probability[i] else m_Alias[i] is. */
+	TArray<float> m_Probability;
+	TArray<int32> m_Alias;
+
+	/** Tables nested deeper than this are ignored. */
+	static const int32 MaxNestingDepth = 8;
+
+	/** The most entries picked and nested tables rolled in one roll, nested quantities multiply so depth alone doesn't bound the work. */
+	static const int32 MaxRollWork = 10000;
+
+	/** Build the alias table from the entry weights. */
+	void Compile();
+
+	/** Clear the nested tables that lead back to this table, a table that contains itself would never stop rolling. */
+	void RemoveCycles();
+
+	/** Can Table be reached through the nested tables of this one? */
+	bool ContainsTable(const UInventoryLootTable* Table, TSet<const UInventoryLootTable*>& Visited) const;
+
+	/** Pick an entry, INDEX_NONE if there are no entries with a weight. */
+	int32 PickEntry(FRandomStream& Stream) const;
+
+	/** @param int32& WorkLeft How many more picks and nested rolls the whole roll can make */
+	void RollInternal(FRandomStream& Stream, TArray<FInventoryItemMeta>& OutItems, int32 Depth, int32& WorkLeft) const;
+
+public:
+
+	/**
+	 * Roll the table and append what dropped. Nothing is merged, duplicates are left to AddItems to stack.
+	 *
+	 * @param FRandomStream& Stream The random stream to roll with, seed it to get the same loot every time
+	 * @param TArray<FInventoryItemMeta>& OutItems The dropped items are added to this
+	 */
+	void Roll(FRandomStream& Stream, TArray<FInventoryItemMeta>& OutItems) const;
+
+	/**
+	 * Roll the table.
+	 *
+	 * @param int32 Seed The seed to roll with, the same seed always gives the same loot
+	 * @return The items that dropped
+	 */
+	UFUNCTION(BlueprintCallable, Category = "TRDWLL|Loot Table")
+	TArray<FInventoryItemMeta> RollLoot(int32 Seed) const;
+
+	/**
+	 * Replace the entries and compile them, for tables built at runtime.
+	 *
+	 * @param const TArray<FLootTableEntry>& Entries The new entries
+	 * @param int32 MinRolls How many times the table is rolled at least
+	 * @param int32 MaxRolls How many times the table is rolled at most
+	 */
+	void SetEntries(const TArray<FLootTableEntry>& Entries, int32 MinRolls = 1, int32 MaxRolls = 1);
+};
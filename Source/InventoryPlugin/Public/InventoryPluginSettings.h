@@ -25,8 +25,35 @@ public:
 	UPROPERTY(EditAnywhere, config, Category = General, DisplayName = "Inventory Items DataTable")
 	FSoftObjectPath m_ActorGroupDataTable;
 
+	/**
+	 * The item database baked from the DataTable with the InventoryItemDatabase commandlet, relative to the Content directory.
+	 * Packaged games and servers use it instead of the DataTable when it exists. (add its folder to Additional Non-Asset Directories To Copy)
+	 */
+	UPROPERTY(EditAnywhere, config, Category = General, DisplayName = "Item Database File")
+	FString m_ItemDatabaseFile;
+
 	UPROPERTY(EditAnywhere, config, Category = General, DisplayName = "Auto stack items")
 	bool m_bAutoStackItems;
 
+	/** The icon shown in a slot while the item's icon is still streaming in. */
+	UPROPERTY(EditAnywhere, config, Category = Icons, DisplayName = "Placeholder Icon")
+	TSoftObjectPtr<class UTexture2D> m_PlaceholderIcon;
+
+	/** How many inventory operations each connection can send per second. (0 to disable the limit) */
+	UPROPERTY(EditAnywhere, config, Category = Networking, DisplayName = "Operations Per Second", meta = (ClampMin = "0"))
+	float m_OperationsPerSecond;
+
+	/** How many inventory operations a connection can send in a burst before it's limited to Operations Per Second. */
+	UPROPERTY(EditAnywhere, config, Category = Networking, DisplayName = "Operation Burst", meta = (ClampMin = "1"))
+	float m_OperationBurst;
+
+	/** How many item icons are kept loaded after they're no longer shown. */
+	UPROPERTY(EditAnywhere, config, Category = Icons, DisplayName = "Icon Cache Size", meta = (ClampMin = "1"))
+	int32 m_IconCacheSize;
+
+	/** The recipes inventories keep track of being able to craft. */
+	UPROPERTY(EditAnywhere, config, Category = Crafting, DisplayName = "Recipes")
+	TArray<TSoftObjectPtr<class UInventoryRecipe>> m_Recipes;
+
 
 };
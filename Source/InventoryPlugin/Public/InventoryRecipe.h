@@ -0,0 +1,39 @@
+/**
+ * Copyright 2019-2020 - Russ 'trdwll' Treadwell https://trdwll.com
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+
+#include "InventorySystem.h"
+
+#include "InventoryRecipe.generated.h"
+
+/**
+ * A crafting recipe, add it to the recipes in the plugin settings for inventories to track it.
+ */
+UCLASS(BlueprintType)
+class INVENTORYPLUGIN_API UInventoryRecipe : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+
+	/** The items used up by crafting the recipe once. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "TRDWLL|Recipe", meta = (DisplayName = "Inputs"))
+	TArray<FInventoryItemMeta> m_Inputs;
+
+	/** The items made by crafting the recipe once. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "TRDWLL|Recipe", meta = (DisplayName = "Outputs"))
+	TArray<FInventoryItemMeta> m_Outputs;
+
+	/**
+	 * Are there enough of every input to craft the recipe?
+	 *
+	 * @param const TMap<FName, int32>& ItemTotals How many of each item there are by row name
+	 * @param int32 Count How many times the recipe would be crafted
+	 */
+	bool HasInputs(const TMap<FName, int32>& ItemTotals, int32 Count = 1) const;
+};
@@ -0,0 +1,63 @@
+/**
+ * Copyright 2019-2020 - Russ 'trdwll' Treadwell https://trdwll.com
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * A word index over the titles and descriptions of every item, built once when the items are loaded so filtering
+ * as the player types never has to look at a string of an item.
+ *
+ * Every word is lowercased and kept once in a sorted array with the items it appears in, so the items with a word that
+ * starts with some text are a binary search and a walk over the words that follow.
+ */
+class INVENTORYPLUGIN_API FInventorySearchIndex
+{
+public:
+
+	void Reset();
+
+	/** Add the text of an item, call Finalize once every item has been added. */
+	void AddItem(const FName& ID, const FString& Title, const FString& PluralTitle, const FString& Description);
+
+	/** Sort the words so the index can be searched. */
+	void Finalize();
+
+	/**
+	 * Find the items that have a word starting with every word of the text. ("red app" finds Red Apple)
+	 *
+	 * @param const FString& Text What's being searched for
+	 * @param TBitArray<>& OutMatches Set for every matching item, indexed like FindItem
+	 * @return False if the text has no words to search for
+	 */
+	bool Search(const FString& Text, TBitArray<>& OutMatches) const;
+
+	/** Get the index of an item in the search results, INDEX_NONE if it isn't in the index. */
+	FORCEINLINE int32 FindItem(const FName& ID) const
+	{
+		const int32* const Index = m_ItemIndex.Find(ID);
+		return Index ? *Index : INDEX_NONE;
+	}
+
+	FORCEINLINE const FName& GetItemID(int32 Index) const { return m_ItemIDs[Index]; }
+
+	/** How many items are in the index. */
+	FORCEINLINE int32 Num() const { return m_ItemIDs.Num(); }
+
+	/** Split text into lowercase words on anything that isn't a letter or a digit. */
+	static void Tokenize(const FString& Text, TArray<FString, TInlineAllocator<16>>& OutWords);
+
+private:
+
+	TArray<FName> m_ItemIDs;
+	TMap<FName, int32> m_ItemIndex;
+
+	/** The words in order and the items each appears in, in the order they were added. */
+	TArray<FString> m_Words;
+	TArray<TArray<int32>> m_Items;
+
+	/** The words while items are being added. */
+	TMap<FString, TArray<int32>> m_PendingWords;
+};
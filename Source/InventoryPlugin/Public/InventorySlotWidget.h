@@ -27,7 +27,7 @@ struct FItemMeta
 	UPROPERTY(BlueprintReadOnly)
 	bool bIsEmptySlot;
 
-	FItemMeta() {}
+	FItemMeta() : bIsValid(false), bIsEmptySlot(true) {}
 	FItemMeta(const FInventoryItemStack& item, bool bValid, bool bEmptySlot) : Item(item), bIsValid(bValid), bIsEmptySlot(bEmptySlot) {}
 };
 
@@ -48,21 +48,84 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Settings", meta = (ExposeOnSpawn = true, DisplayName = "Inventory Component"))
 	UInventoryComponent* m_Inventory;
 
+	/** The item that was in the slot the last time it was refreshed. */
+	UPROPERTY(BlueprintReadOnly, Category = "TRDWLL|Inventory System", meta = (DisplayName = "Cached Item"))
+	FItemMeta m_CachedItem;
+
+	/** The slot version m_CachedItem was built from. */
+	int32 m_CachedVersion;
+
+	/** The inventory whose OnSlotChanged we're currently bound to. */
+	UPROPERTY()
+	UInventoryComponent* m_BoundInventory;
+
+	/** The icon of the item in the slot, or the placeholder while it's streaming in. */
+	UPROPERTY(BlueprintReadOnly, Category = "TRDWLL|Inventory System", meta = (DisplayName = "Icon"))
+	class UTexture2D* m_Icon;
+
+	/** Called when the slot has changed, update the visuals here instead of binding to GetItemByIndex. */
+	UFUNCTION(BlueprintImplementableEvent, Category = "TRDWLL|Inventory System")
+	void OnSlotRefreshed(const FItemMeta& Item);
+
+	/** Called when the icon for the slot changes. (either straight away or once it has streamed in) */
+	UFUNCTION(BlueprintImplementableEvent, Category = "TRDWLL|Inventory System")
+	void OnIconChanged(class UTexture2D* Icon);
+
+	UFUNCTION()
+	void HandleSlotChanged(int32 SlotIndex);
+
+	void HandleIconLoaded(class UTexture2D* Icon, FSoftObjectPath IconPath);
+
+	/** Request the icon of the cached item from the icon cache. */
+	void UpdateIcon();
+
+	void BindToInventory();
+	void UnbindFromInventory();
+
+	virtual void NativeConstruct() override;
+	virtual void NativeDestruct() override;
+
 public:
 
 	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory System")
 	FORCEINLINE int32 GetSlotID() const { return m_SlotID;  }
 
+	/** Get the item in the slot as of the last refresh. */
+	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory System")
+	FORCEINLINE const FItemMeta& GetCachedItem() const { return m_CachedItem; }
+
+	/** NOTE: This copies the slot every time it's evaluated, prefer OnSlotRefreshed/GetCachedItem for bindings. */
 	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory System")
 	FORCEINLINE FItemMeta GetItemByIndex()
 	{
-		bool bIsValidIndex = m_Inventory->GetInventoryItems().IsValidIndex(m_SlotID);
-		FInventoryItemStack& Item = m_Inventory->GetInventoryItems()[m_SlotID];
+		if (m_Inventory == nullptr || !m_Inventory->GetInventoryItems().IsValidIndex(m_SlotID))
+		{
+			return FItemMeta();
+		}
+
+		const FInventoryItemStack& Item = m_Inventory->GetDisplayedSlot(m_SlotID);
 
-		FItemMeta item(Item, bIsValidIndex, Item.IsEmptySlot());
+		FItemMeta item(Item, true, Item.IsEmptySlot());
 		return item;
 	}
 
+	/**
+	 * Point this widget at a slot. Used by the grid widget to recycle slot widgets while scrolling.
+	 *
+	 * @param UInventoryComponent* Inventory The inventory that owns the slot
+	 * @param int32 SlotID The index of the slot to show
+	 */
+	UFUNCTION(BlueprintCallable, Category = "TRDWLL|Inventory System")
+	void SetSlot(UInventoryComponent* Inventory, int32 SlotID);
+
+	/**
+	 * Rebuild the cached item if the slot's version has changed.
+	 *
+	 * @param bool bForce Refresh even if the version hasn't changed
+	 */
+	UFUNCTION(BlueprintCallable, Category = "TRDWLL|Inventory System")
+	void RefreshSlot(bool bForce = false);
+
 	virtual FReply NativeOnMouseButtonDown(const FGeometry& InGeometry, const FPointerEvent& InMouseEvent) override;
 	virtual void NativeOnDragDetected(const FGeometry& InGeometry, const FPointerEvent& InMouseEvent, UDragDropOperation*& OutOperation) override;
 	virtual bool NativeOnDrop(const FGeometry& InGeometry, const FDragDropEvent& InDragDropEvent, UDragDropOperation* InOperation) override;
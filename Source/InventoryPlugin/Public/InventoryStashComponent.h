@@ -0,0 +1,77 @@
+/**
+ * Copyright 2019-2020 - Russ 'trdwll' Treadwell https://trdwll.com
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "InventoryComponent.h"
+
+#include "InventoryStashComponent.generated.h"
+
+/**
+ * A shared inventory with thousands of slots, such as a guild stash. The slots don't replicate, instead every viewer
+ * picks a page and is only sent the slots of that page when they change. Pages nobody is viewing cost nothing.
+ */
+UCLASS(ClassGroup=(TRDWLL), meta=(BlueprintSpawnableComponent))
+class INVENTORYPLUGIN_API UInventoryStashComponent final : public UInventoryComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	UInventoryStashComponent();
+
+protected:
+
+	virtual void MarkSlotDirty(int32 Index) override;
+
+	/** How many slots there are on a page. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "TRDWLL|Inventory Stash", meta = (ClampMin = "1", ClampMax = "500", DisplayName = "Page Size"))
+	int32 m_PageSize;
+
+private:
+
+	/** Server: The page each viewer is viewing. */
+	TMap<TWeakObjectPtr<UInventoryComponent>, int32> m_ViewerPages;
+
+	/** Server: How many viewers each page has. */
+	TMap<int32, int32> m_PageViewerCounts;
+
+	/** Server: Slots on a viewed page that changed since the last flush. */
+	TSet<int32> m_DirtySlots;
+	bool m_bFlushPending;
+
+	/** Send the changed slots to the viewers of their page. */
+	void FlushPages();
+
+	/** Send every slot of a page to a viewer. */
+	void SendPage(UInventoryComponent* Viewer, int32 Page);
+
+	void AddPageViewer(int32 Page, int32 Delta);
+
+public:
+
+	/**
+	 * Server: Set the page a viewer receives, sending them the whole page.
+	 *
+	 * @param UInventoryComponent* Viewer The inventory of the viewing player, the slots are sent to its owner
+	 * @param int32 Page The page (INDEX_NONE to stop viewing)
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "TRDWLL|Inventory Stash")
+	void SetViewerPage(UInventoryComponent* Viewer, int32 Page);
+
+	/** Server: Can the player with this inventory view the stash? Override it to check guild membership etc. */
+	UFUNCTION(BlueprintNativeEvent, Category = "TRDWLL|Inventory Stash")
+	bool CanView(UInventoryComponent* Viewer) const;
+
+	/** Client: Write the slots of a page sent by the server. */
+	void ReceiveSlots(const TArray<FInventorySlotUpdate>& Slots);
+
+	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory Stash")
+	FORCEINLINE int32 GetPageSize() const { return m_PageSize; }
+
+	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory Stash")
+	FORCEINLINE int32 GetPageCount() const { return FMath::DivideAndRoundUp(GetInventoryItems().Num(), FMath::Max(1, m_PageSize)); }
+};
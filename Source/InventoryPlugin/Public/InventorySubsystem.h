@@ -0,0 +1,196 @@
+/**
+ * Copyright 2019-2020 - Russ 'trdwll' Treadwell https://trdwll.com
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "InventorySystem.h"
+#include "InventoryTimingWheel.h"
+
+#include "InventorySubsystem.generated.h"
+
+/** How many inventory operations a connection is allowed to send right now. */
+struct FInventoryOperationBudget
+{
+	/** Operations that can be spent right now, refilled over time up to the burst size. */
+	float Tokens;
+
+	/** When Tokens was last refilled. */
+	float LastRefillTime;
+
+	/** Operations from this connection that were dropped or coalesced away. */
+	int32 DroppedOperations;
+	int32 CoalescedOperations;
+
+	FInventoryOperationBudget() : Tokens(0.0f), LastRefillTime(0.0f), DroppedOperations(0), CoalescedOperations(0) {}
+};
+
+enum class EInventoryTimer : uint8
+{
+	/** A stack's condition runs out. */
+	Expiry,
+	/** A cast finishes. */
+	Cast,
+	/** A cooldown ends. */
+	Cooldown
+};
+
+/** A timer scheduled for an inventory, the inventory uses Key to tell if it's stale. (the slot version, cast serial etc) */
+struct FInventoryTimer
+{
+	TWeakObjectPtr<class UInventoryComponent> Inventory;
+	EInventoryTimer Type;
+	int32 SlotIndex;
+	int32 Key;
+
+	FInventoryTimer() : Type(EInventoryTimer::Expiry), SlotIndex(INDEX_NONE), Key(0) {}
+	FInventoryTimer(class UInventoryComponent* InInventory, EInventoryTimer InType, int32 InSlotIndex, int32 InKey) : Inventory(InInventory), Type(InType), SlotIndex(InSlotIndex), Key(InKey) {}
+};
+
+/**
+ * Work out what a slot should become during a pass over every inventory. Runs on worker threads so it must not touch UObjects or shared state without locking.
+ * Return true and fill OutSlot to change the slot (an empty stack clears it), return false to leave it alone.
+ */
+typedef TFunctionRef<bool(const FInventoryItemStack& Slot, FInventoryItemStack& OutSlot)> FInventorySlotTransform;
+
+/**
+ * Server wide bookkeeping for the inventory components in a world.
+ */
+UCLASS()
+class INVENTORYPLUGIN_API UInventorySubsystem final : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+	/** The operation budget of each connection that has sent inventory operations. */
+	TMap<TWeakObjectPtr<class UNetConnection>, FInventoryOperationBudget> m_Budgets;
+
+	/** Totals across every connection. */
+	int32 m_DroppedOperations;
+	int32 m_CoalescedOperations;
+
+	/** Every inventory in the world that's on the server. */
+	TArray<TWeakObjectPtr<class UInventoryComponent>> m_Inventories;
+
+	/** The last item instance ID that was handed out. */
+	int32 m_LastInstanceID;
+
+	/** Timers for every inventory, such as when stacks spoil and cooldowns end. */
+	TInventoryTimingWheel<FInventoryTimer> m_Timers;
+
+	/** Wakes the subsystem up when the wheel next has something to do. */
+	FTimerHandle m_TimerHandle;
+	float m_TimerWakeTime;
+
+	/** Set the timer for the wheel's next event if it's sooner than the one that's set. */
+	void ArmTimers();
+
+	/** Fire the timers that are due. */
+	void AdvanceTimers();
+
+	/** Inventories that changed this frame and need a new snapshot. */
+	TArray<TWeakObjectPtr<class UInventoryComponent>> m_PendingSnapshots;
+
+	FDelegateHandle m_PostActorTickHandle;
+
+	/** Publish the snapshots of the inventories that changed, once every actor has ticked. */
+	void PublishSnapshots(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+
+	/** Operations refilled per second and the most that can be saved up. (from the plugin settings) */
+	float m_OperationsPerSecond;
+	float m_OperationBurst;
+
+public:
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/**
+	 * Spend an operation from a connection's budget. Operations without a connection (the listen server's own player) are always allowed.
+	 *
+	 * @param UNetConnection* Connection The connection that sent the operation
+	 * @return False if the connection is over budget and the operation should be dropped
+	 */
+	bool ConsumeOperationBudget(class UNetConnection* Connection);
+
+	/** Count operations that were cancelled out by later operations before being applied. */
+	void RecordCoalescedOperations(class UNetConnection* Connection, int32 Count);
+
+	/** Get how many operations were dropped for being over budget. */
+	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory System")
+	FORCEINLINE int32 GetDroppedOperationCount() const { return m_DroppedOperations; }
+
+	/** Get how many operations were coalesced away. */
+	UFUNCTION(BlueprintPure, Category = "TRDWLL|Inventory System")
+	FORCEINLINE int32 GetCoalescedOperationCount() const { return m_CoalescedOperations; }
+
+	/**
+	 * Server: Call UInventoryComponent::OnInventoryTimer at a time. Nothing ticks while waiting.
+	 *
+	 * @param UInventoryComponent* Inventory The inventory to call
+	 * @param EInventoryTimer Type What the timer is for
+	 * @param int32 SlotIndex The slot the timer is for (INDEX_NONE if it isn't for a slot)
+	 * @param int32 Key Passed back so the inventory can ignore the timer if it's stale
+	 * @param float Time The world time to fire at
+	 */
+	void ScheduleTimer(class UInventoryComponent* Inventory, EInventoryTimer Type, int32 SlotIndex, int32 Key, float Time);
+
+	/** Server: Get a new item instance ID, unique across every inventory in the world. */
+	FORCEINLINE int32 AllocateInstanceID() { return ++m_LastInstanceID; }
+
+	/** Server: Called by inventories as they begin and end play. */
+	void RegisterInventory(class UInventoryComponent* Inventory);
+	void UnregisterInventory(class UInventoryComponent* Inventory);
+
+	/**
+	 * Server: Run a transform over every slot of every inventory on worker threads. The changes are written back on the game thread
+	 * once every inventory has been processed, each inventory in a single change batch so it goes out in one replication update.
+	 *
+	 * @param FInventorySlotTransform Transform Called for every non-empty slot
+	 * @return How many slots were changed
+	 */
+	int32 TransformAllInventories(FInventorySlotTransform Transform);
+
+	/**
+	 * Server: Remove items from every inventory, such as items that were removed in a patch.
+	 *
+	 * @param const TArray<FName>& ItemIDs The row names of the items to remove
+	 * @return How many slots were cleared
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "TRDWLL|Inventory System")
+	int32 RemoveItemsFromAllInventories(const TArray<FName>& ItemIDs);
+
+	/**
+	 * Server: Give items to every player's inventory, such as event rewards. Containers, bags and stashes are left out.
+	 * Inserting needs each inventory's stacking index so this runs on the game thread.
+	 *
+	 * @param const TArray<FInventoryItemMeta>& Items The items to give each inventory
+	 * @return How many items were added across every inventory
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "TRDWLL|Inventory System")
+	int32 GrantItemsToAllInventories(const TArray<FInventoryItemMeta>& Items);
+
+	/**
+	 * Server: Send item definitions that changed while running to every connection with an inventory, once per connection.
+	 *
+	 * @param int32 Version The registry version the definitions are from
+	 * @param const TArray<FInventoryItem>& Items The definitions that changed
+	 * @param const TArray<FName>& RemovedItems The items that no longer have a definition
+	 */
+	void SendItemDefinitions(int32 Version, const TArray<FInventoryItem>& Items, const TArray<FName>& RemovedItems);
+
+	/** Publish a new snapshot of an inventory at the end of the frame, see UInventoryComponent::GetSnapshot. */
+	void QueueSnapshot(class UInventoryComponent* Inventory);
+
+	/**
+	 * Server: Get the latest snapshot of every inventory, to hand to another thread. (saving, exporting etc)
+	 *
+	 * @param TArray<FInventorySnapshotPtr>& OutSnapshots The snapshots of every inventory that has published one
+	 */
+	void GetInventorySnapshots(TArray<TSharedPtr<const struct FInventorySnapshot, ESPMode::ThreadSafe>>& OutSnapshots) const;
+
+	/** Get the budget of a connection, nullptr if it hasn't sent any operations. */
+	const FInventoryOperationBudget* GetOperationBudget(class UNetConnection* Connection) const { return m_Budgets.Find(Connection); }
+};
@@ -54,25 +54,72 @@ struct FInventoryItem : public FTableRowBase
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Inventory System", meta = (ClampMin = "0", ClampMax = "10000"))
 	float Weight;
 
-	/** The icon that will be displayed in the inventory. (Recommended 128x128) */
+	/** How many seconds a fresh item lasts before it spoils or wears out. (0 to never decay) */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Inventory System", meta = (ClampMin = "0"))
+	float ConditionLifetime;
+
+	/** How much condition is lost every time the item is used. (0 to 1) */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Inventory System", meta = (ClampMin = "0", ClampMax = "1"))
+	float ConditionLossPerUse;
+
+	/** The item this turns into when its condition runs out, such as rotten food. (None to remove it) */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Inventory System")
+	FName ExpiredItemRowName;
+
+	/** How many columns and rows of the grid the item takes up, for inventories that use footprints. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Inventory System", meta = (ClampMin = "1", ClampMax = "64"))
+	FIntPoint Footprint;
+
+	/** Can the item be turned sideways to fit? */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Inventory System")
-	class UTexture2D* Icon;
+	bool bCanRotate;
+
+	/** How many slots the item has if it's a bag. (0 if it isn't one) Bags can't go into other bags. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Inventory System", meta = (ClampMin = "0", ClampMax = "255"))
+	int32 BagSlots;
 
-	/** The reference to the actor that has been picked up or dropped. */
+	/** Items in the same group share a cooldown, such as every health potion. (None for the item to have its own) */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Inventory System")
-	TSubclassOf<class AInventoryBaseItem> ObjectClass;
+	FName CooldownGroup;
+
+	/** How many seconds after being used before the item (or its group) can be used again. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Inventory System", meta = (ClampMin = "0"))
+	float Cooldown;
+
+	/** How many seconds the item takes to use. It's used when the cast finishes and the cast is interrupted if the slot changes. (0 for instant) */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Inventory System", meta = (ClampMin = "0"))
+	float CastTime;
+
+	/** The icon that will be displayed in the inventory. (Recommended 128x128) Streamed in when a slot showing it becomes visible. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Inventory System")
+	TSoftObjectPtr<class UTexture2D> Icon;
+
+	/** The reference to the actor that has been picked up or dropped. Preloaded by the server while the item is held. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Inventory System")
+	TSoftClassPtr<class AInventoryBaseItem> ObjectClass;
 
 	/** What should happen to this item when used? */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Inventory System")
 	EInventoryItemAction ItemAction;
 
+	/** The row name of the item in the item DataTable. Filled in on the copies the item subsystem hands out, never on the table. */
+	UPROPERTY(BlueprintReadOnly, Category = "Inventory System")
+	FName ID;
+
 	// TODO: Add staticmesh to allow viewing the item (like Skyrim)
 	// TODO: Add MoveSound, DropSound, PickupSound
 
 
+	/** Items are the same item if they have the same key, so equal stacks are always counted and indexed together. */
 	FORCEINLINE bool operator==(const FInventoryItem& Other) const
 	{
-		return Title == Other.Title;
+		return GetKey() == Other.GetKey();
+	}
+
+	/** Get the key items are indexed by. (the ID, or the title for items that didn't come from the DataTable) */
+	FORCEINLINE FName GetKey() const
+	{
+		return ID.IsNone() ? FName(*Title) : ID;
 	}
 
 	FORCEINLINE bool CanStack() const
@@ -81,7 +128,24 @@ struct FInventoryItem : public FTableRowBase
 	}
 
 	// TODO: Add more constructors with params
-	FInventoryItem() : MaxStackSize(2), bAutoStack(true), Icon(nullptr), ItemAction(EInventoryItemAction::IIA_None) {}
+	/** Get the group the cooldown of this item is tracked under. */
+	FORCEINLINE FName GetCooldownGroup() const
+	{
+		return CooldownGroup.IsNone() ? GetKey() : CooldownGroup;
+	}
+
+	FORCEINLINE bool IsBag() const
+	{
+		return BagSlots > 0;
+	}
+
+	/** Does the condition of this item go down? */
+	FORCEINLINE bool HasCondition() const
+	{
+		return ConditionLifetime > 0.0f || ConditionLossPerUse > 0.0f;
+	}
+
+	FInventoryItem() : MaxStackSize(2), bAutoStack(true), Weight(0.0f), ConditionLifetime(0.0f), ConditionLossPerUse(0.0f), Footprint(1, 1), bCanRotate(true), BagSlots(0), Cooldown(0.0f), CastTime(0.0f), ItemAction(EInventoryItemAction::IIA_None) {}
 };
 
 USTRUCT(BlueprintType)
@@ -96,9 +160,75 @@ struct FInventoryItemStack
 	UPROPERTY(BlueprintReadWrite, Category = "Inventory System")
 	int32 StackSize;
 
-	FInventoryItemStack() : InventoryItem(FInventoryItem()), StackSize(0) {}
-	FInventoryItemStack(const FInventoryItem& item) : InventoryItem(item) {}
-	FInventoryItemStack(const FInventoryItem& item, int32 stackSize) : InventoryItem(item), StackSize(stackSize) {}
+	/** Bumped by the inventory every time the slot holding this stack changes. */
+	UPROPERTY(BlueprintReadOnly, Category = "Inventory System")
+	int32 Version;
+
+	/** Identifies the instance data of the stack in its inventory, 0 if it has none. Stacks with instance data never merge or split. */
+	UPROPERTY(BlueprintReadOnly, Category = "Inventory System")
+	int32 InstanceID;
+
+	/** Is the item turned sideways in the grid? */
+	UPROPERTY(BlueprintReadOnly, Category = "Inventory System")
+	bool bRotated;
+
+	/** The condition of the stack at ConditionTime. (1 is fresh/new, 0 is spoiled/broken) Use GetCondition for the condition right now. */
+	UPROPERTY(BlueprintReadOnly, Category = "Inventory System")
+	float Condition;
+
+	/** The server time Condition was worked out at. (negative until the stack is put in an inventory) */
+	UPROPERTY(BlueprintReadOnly, Category = "Inventory System")
+	float ConditionTime;
+
+	FInventoryItemStack() : InventoryItem(FInventoryItem()), StackSize(0), Version(0), InstanceID(0), bRotated(false), Condition(1.0f), ConditionTime(-1.0f) {}
+	FInventoryItemStack(const FInventoryItem& item) : InventoryItem(item), StackSize(0), Version(0), InstanceID(0), bRotated(false), Condition(1.0f), ConditionTime(-1.0f) {}
+	FInventoryItemStack(const FInventoryItem& item, int32 stackSize) : InventoryItem(item), StackSize(stackSize), Version(0), InstanceID(0), bRotated(false), Condition(1.0f), ConditionTime(-1.0f) {}
+
+	/** Get the condition at a point in time, worked out from the stored condition so nothing has to tick. */
+	FORCEINLINE float GetCondition(float Now) const
+	{
+		if (InventoryItem.ConditionLifetime <= 0.0f || ConditionTime < 0.0f)
+		{
+			return Condition;
+		}
+
+		return FMath::Max(0.0f, Condition - (Now - ConditionTime) / InventoryItem.ConditionLifetime);
+	}
+
+	/** When the condition runs out, negative if it never does on its own. */
+	FORCEINLINE float GetExpiryTime() const
+	{
+		return InventoryItem.ConditionLifetime > 0.0f && ConditionTime >= 0.0f ? ConditionTime + Condition * InventoryItem.ConditionLifetime : -1.0f;
+	}
+
+	/** Store the condition as of now. */
+	FORCEINLINE void SettleCondition(float Now)
+	{
+		Condition = GetCondition(Now);
+		ConditionTime = Now;
+	}
+
+	/** Set the condition to the average of this stack and Quantity items of another weighted by count, call before adding them to StackSize. */
+	void MergeCondition(const FInventoryItemStack& Other, int32 Quantity, float Now)
+	{
+		const int32 Total = StackSize + Quantity;
+		if (Total <= 0)
+		{
+			return;
+		}
+
+		Condition = (GetCondition(Now) * StackSize + Other.GetCondition(Now) * Quantity) / Total;
+		ConditionTime = Now;
+	}
+
+	/**
+	 * Stacks of items from the item DataTable only send the row name of the item, the receiver fills in the rest from its own
+	 * item registry. Changing the definition of an item never has to resend the slots holding it.
+	 */
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
+	/** Compares everything but the definition of an item from the DataTable, which every machine looks up itself. */
+	bool Identical(const FInventoryItemStack* Other, uint32 PortFlags) const;
 
 	FORCEINLINE bool operator==(const FInventoryItemStack& Other) const
 	{
@@ -109,7 +239,26 @@ struct FInventoryItemStack
 	FORCEINLINE int32 GetEmptySizeLeft() const { return InventoryItem.MaxStackSize - StackSize; }
 	FORCEINLINE bool IsEmptySlot() const { return &InventoryItem == nullptr || StackSize <= 0; }
 	FORCEINLINE bool CanBeStacked() const { return GetEmptySizeLeft() < StackSize; }
+	FORCEINLINE float GetWeight() const { return InventoryItem.Weight * StackSize; }
 	FORCEINLINE bool IsAStack() const { return StackSize >= 2; }
+	FORCEINLINE bool HasInstanceData() const { return InstanceID != 0; }
+
+	/** Get how many columns and rows the stack takes up in the grid, turned if the stack is. */
+	FORCEINLINE FIntPoint GetFootprint() const
+	{
+		const FIntPoint Size(FMath::Max(1, InventoryItem.Footprint.X), FMath::Max(1, InventoryItem.Footprint.Y));
+		return bRotated ? FIntPoint(Size.Y, Size.X) : Size;
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FInventoryItemStack> : public TStructOpsTypeTraitsBase2<FInventoryItemStack>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithIdentical = true,
+	};
 };
 
 USTRUCT(BlueprintType)
@@ -122,7 +271,7 @@ struct FInventoryItemMeta
 	FName ItemRowName;
 
 	/** Used for when an item is dropped. */
-	UPROPERTY(BlueprintReadOnly, Category = "Inventory System")
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Inventory System", meta = (ClampMin = "1"))
 	int32 Quantity;
 
 	FInventoryItemMeta() : ItemRowName("Apple"), Quantity(1) {}
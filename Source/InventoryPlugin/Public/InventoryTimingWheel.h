@@ -0,0 +1,190 @@
+/**
+ * Copyright 2019-2020 - Russ 'trdwll' Treadwell https://trdwll.com
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * A hierarchical timing wheel. Scheduling is O(1) and nothing is looked at until its bucket comes up, so it can hold
+ * any number of far apart deadlines (spoiling food, cooldowns etc) without anything having to tick.
+ *
+ * There's no cancel, the owner should check the payload is still current when it fires and ignore it if it isn't.
+ */
+template<typename PayloadType>
+class TInventoryTimingWheel
+{
+	/** 4 levels of 64 buckets, each level's bucket covers a whole turn of the level below. */
+	static const int32 BucketBits = 6;
+	static const int32 BucketCount = 1 << BucketBits;
+	static const int32 LevelCount = 4;
+
+	struct FEntry
+	{
+		uint64 Tick;
+		PayloadType Payload;
+
+		FEntry(uint64 InTick, const PayloadType& InPayload) : Tick(InTick), Payload(InPayload) {}
+	};
+
+	TArray<FEntry> m_Buckets[LevelCount][BucketCount];
+
+	/** Entries too far out for the wheel. */
+	TArray<FEntry> m_Overflow;
+
+	/** How long a tick is in seconds. */
+	float m_TickLength;
+
+	/** The last tick that has been processed. */
+	uint64 m_CurrentTick;
+
+	/** How many entries are in the wheel. */
+	int32 m_Num;
+
+	uint64 TimeToTick(float Time) const
+	{
+		return Time <= 0.0f ? 0 : (uint64)FMath::CeilToDouble((double)Time / m_TickLength);
+	}
+
+	void Insert(FEntry&& Entry)
+	{
+		// Deadlines that have passed go in the next bucket
+		Entry.Tick = FMath::Max(Entry.Tick, m_CurrentTick + 1);
+
+		// The lowest level whose turn contains the deadline
+		for (int32 Level = 0; Level < LevelCount; Level++)
+		{
+			const int32 Shift = BucketBits * (Level + 1);
+			if ((Entry.Tick >> Shift) == (m_CurrentTick >> Shift))
+			{
+				const int32 Bucket = (int32)((Entry.Tick >> (BucketBits * Level)) & (BucketCount - 1));
+				m_Buckets[Level][Bucket].Add(MoveTemp(Entry));
+				return;
+			}
+		}
+
+		// Past the end of the top level's turn, looked at again when the next turn starts
+		m_Overflow.Add(MoveTemp(Entry));
+	}
+
+	/** Put the entries from a bucket that just came up back into the wheel. */
+	void Cascade(TArray<FEntry>& Bucket)
+	{
+		TArray<FEntry> Cascading = MoveTemp(Bucket);
+		Bucket.Reset();
+
+		for (FEntry& Entry : Cascading)
+		{
+			if (Entry.Tick <= m_CurrentTick)
+			{
+				m_Buckets[0][m_CurrentTick & (BucketCount - 1)].Add(MoveTemp(Entry));
+			}
+			else
+			{
+				Insert(MoveTemp(Entry));
+			}
+		}
+	}
+
+	/** The first tick after the current one that has a bucket to fire or cascade, 0 if the wheel is empty. */
+	uint64 GetNextEventTick() const
+	{
+		for (int32 Level = 0; Level < LevelCount; Level++)
+		{
+			const int32 Shift = BucketBits * Level;
+			const int32 Current = (int32)((m_CurrentTick >> Shift) & (BucketCount - 1));
+
+			for (int32 Bucket = Current + 1; Bucket < BucketCount; Bucket++)
+			{
+				if (m_Buckets[Level][Bucket].Num() > 0)
+				{
+					const int32 TurnShift = Shift + BucketBits;
+					return ((m_CurrentTick >> TurnShift) << TurnShift) | (uint64(Bucket) << Shift);
+				}
+			}
+		}
+
+		if (m_Overflow.Num() > 0)
+		{
+			const int32 TurnShift = BucketBits * LevelCount;
+			return ((m_CurrentTick >> TurnShift) + 1) << TurnShift;
+		}
+
+		return 0;
+	}
+
+public:
+
+	explicit TInventoryTimingWheel(float TickLength = 0.25f) : m_TickLength(FMath::Max(TickLength, KINDA_SMALL_NUMBER)), m_CurrentTick(0), m_Num(0) {}
+
+	/**
+	 * Add a deadline.
+	 *
+	 * @param float Time When the payload should fire (in the same time as Advance is called with)
+	 * @param const PayloadType& Payload What is passed back when it fires
+	 */
+	void Schedule(float Time, const PayloadType& Payload)
+	{
+		Insert(FEntry(TimeToTick(Time), Payload));
+		m_Num++;
+	}
+
+	/**
+	 * Move the wheel forward, firing everything that's due.
+	 *
+	 * @param float Now The current time
+	 * @param TFunctionRef<void(const PayloadType&)> OnFired Called for every payload that is due, it's safe to schedule from here
+	 */
+	void Advance(float Now, TFunctionRef<void(const PayloadType&)> OnFired)
+	{
+		const uint64 TargetTick = (uint64)FMath::FloorToDouble((double)FMath::Max(Now, 0.0f) / m_TickLength);
+
+		while (m_CurrentTick < TargetTick)
+		{
+			const uint64 NextTick = GetNextEventTick();
+
+			// Nothing to do before the target, skip straight to it
+			if (NextTick == 0 || NextTick > TargetTick)
+			{
+				m_CurrentTick = TargetTick;
+				break;
+			}
+
+			m_CurrentTick = NextTick;
+
+			// Move the buckets that just came up on the upper levels down to the levels below
+			if ((m_CurrentTick & ((uint64(1) << (BucketBits * LevelCount)) - 1)) == 0)
+			{
+				Cascade(m_Overflow);
+			}
+
+			for (int32 Level = LevelCount - 1; Level > 0; Level--)
+			{
+				const int32 Shift = BucketBits * Level;
+				if ((m_CurrentTick & ((uint64(1) << Shift) - 1)) == 0)
+				{
+					Cascade(m_Buckets[Level][(m_CurrentTick >> Shift) & (BucketCount - 1)]);
+				}
+			}
+
+			TArray<FEntry> Due = MoveTemp(m_Buckets[0][m_CurrentTick & (BucketCount - 1)]);
+			m_Num -= Due.Num();
+
+			for (const FEntry& Entry : Due)
+			{
+				OnFired(Entry.Payload);
+			}
+		}
+	}
+
+	/** When Advance next has something to do, a negative number if the wheel is empty. */
+	float GetNextEventTime() const
+	{
+		const uint64 NextTick = m_Num > 0 ? GetNextEventTick() : 0;
+		return NextTick > 0 ? (float)(NextTick * m_TickLength) : -1.0f;
+	}
+
+	/** How many payloads are waiting to fire. */
+	FORCEINLINE int32 Num() const { return m_Num; }
+};